@@ -24,6 +24,7 @@
 
 #include "af80.h"
 #include "atari.h"
+#include "cartridge.h"
 #include "util.h"
 #include "log.h"
 #include "memory.h"
@@ -104,6 +105,7 @@ static void update_d5(void)
 static void update_8000_9fff(void)
 {
 	if (not_right_cartridge_rd4_control) return;
+	CARTRIDGE_Unmap809F();
 	if (not_rom_output_enable) {
 		memset(MEMORY_mem + 0x8000, 0xff, 0x2000);
 	}
@@ -304,6 +306,7 @@ void AF80_D5PutByte(UWORD addr, UBYTE byte)
 			not_right_cartridge_rd4_control = (byte & 0x20);
 			if (not_right_cartridge_rd4_control) {
 				MEMORY_Cart809fDisable();
+				CARTRIDGE_Unmap809F();
 			}
 			else {
 				MEMORY_Cart809fEnable();
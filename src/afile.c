@@ -41,6 +41,13 @@
 #include <stdio.h>
 
 
+/* 40K or a-power-of-two between 4K and CARTRIDGE_MAX_SIZE */
+static int IsRomLength(int file_length)
+{
+	return file_length >= 4 * 1024 && file_length <= CARTRIDGE_MAX_SIZE
+	    && ((file_length & (file_length - 1)) == 0 || file_length == 40 * 1024);
+}
+
 int AFILE_DetectFileType(const char *filename)
 {
 	UBYTE header[4];
@@ -70,7 +77,16 @@ int AFILE_DetectFileType(const char *filename)
 			return AFILE_ERROR;
 #else /* HAVE_LIBZ */
 			gzFile gzf;
+			UBYTE trailer[4];
+			ULONG isize;
+			/* the gzip trailer holds the length of the uncompressed data */
+			if (fseek(fp, -4, SEEK_END) != 0 || fread(trailer, 1, 4, fp) != 4) {
+				fclose(fp);
+				return AFILE_ERROR;
+			}
 			fclose(fp);
+			isize = (ULONG) trailer[0] | ((ULONG) trailer[1] << 8)
+			      | ((ULONG) trailer[2] << 16) | ((ULONG) trailer[3] << 24);
 			gzf = gzopen(filename, "rb");
 			if (gzf == NULL)
 				return AFILE_ERROR;
@@ -83,6 +99,13 @@ int AFILE_DetectFileType(const char *filename)
 				return AFILE_ATR_GZ;
 			if (header[0] == 'A' && header[1] == 'T' && header[2] == 'A' && header[3] == 'R')
 				return AFILE_STATE_GZ;
+			/* BINLOAD_Loader() and CARTRIDGE_Insert() uncompress these themselves */
+			if (header[0] == 0xff && header[1] == 0xff && (header[2] != 0xff || header[3] != 0xff))
+				return AFILE_XEX;
+			if (header[0] == 'C' && header[1] == 'A' && header[2] == 'R' && header[3] == 'T')
+				return AFILE_CART;
+			if (isize <= CARTRIDGE_MAX_SIZE && IsRomLength((int) isize))
+				return AFILE_ROM;
 			return AFILE_XFD_GZ;
 #endif /* HAVE_LIBZ */
 		}
@@ -149,9 +172,7 @@ int AFILE_DetectFileType(const char *filename)
 #endif
 		return AFILE_PRO;
 	}
-	/* 40K or a-power-of-two between 4K and CARTRIDGE_MAX_SIZE */
-	if (file_length >= 4 * 1024 && file_length <= CARTRIDGE_MAX_SIZE
-	 && ((file_length & (file_length - 1)) == 0 || file_length == 40 * 1024))
+	if (IsRomLength(file_length))
 		return AFILE_ROM;
 	/* BOOT_TAPE is a raw file containing a program booted from a tape */
 	if ((header[1] << 7) == file_length)
@@ -647,12 +647,22 @@ UWORD ANTIC_cl[128];
 
 #endif /* WORDS_UNALIGNED_OK */
 
+#ifdef WORDS_UNALIGNED_OK
+/* Each 8 bits of screendata_tally select two neighbouring hi-res pixel
+   pairs, so four pixel pairs are written with two lookups. */
+#define DRAW_ARTIF_NEW { \
+		WRITE_VIDEO_LONG_UNALIGNED((ULONG *) ptr, art_lookup_new_pairs[(UBYTE) (screendata_tally >> 10)]); \
+		WRITE_VIDEO_LONG_UNALIGNED(((ULONG *) ptr) + 1, art_lookup_new_pairs[(UBYTE) (screendata_tally >> 6)]); \
+		ptr += 4; \
+	}
+#else
 #define DRAW_ARTIF_NEW {\
 		WRITE_VIDEO(ptr++, art_lookup_new[(screendata_tally & 0x03f000) >> 12]); \
 		WRITE_VIDEO(ptr++, art_lookup_new[(screendata_tally & 0x00fc00) >> 10]); \
 		WRITE_VIDEO(ptr++, art_lookup_new[(screendata_tally & 0x003f00) >> 8]); \
 		WRITE_VIDEO(ptr++, art_lookup_new[(screendata_tally & 0x000fc0) >> 6]); \
 	}
+#endif /* WORDS_UNALIGNED_OK */
 
 /* Hi-res modes optimizations
    Now hi-res modes are drawn with words, not bytes. Endianess defaults
@@ -884,6 +894,15 @@ int ANTIC_artif_mode;
 static UWORD art_lookup_new[64];
 static UWORD art_colour1_new;
 static UWORD art_colour2_new;
+#ifndef USE_COLOUR_TRANSLATION_TABLE
+/* art_lookup_new expanded to 8-bit patterns: entry i holds the colours of
+   art_lookup_new[i >> 2] and art_lookup_new[i & 0x3f], in screen order. */
+static ULONG art_lookup_new_pairs[256];
+/* Colours the two tables above were computed for. The tables are rebuilt
+   only when these change, not on every scanline. */
+static UWORD art_new_key[5];
+static int art_new_valid = FALSE;
+#endif
 
 static ULONG art_lookup_normal[256];
 static ULONG art_lookup_reverse[256];
@@ -1414,6 +1433,32 @@ static void draw_an_gtia_bug(const ULONG *t_pm_scanline_ptr)
 	art_lookup_new[6] = art_lookup_new[22] = art_lookup_new[38] = art_lookup_new[54] = (ANTIC_cl[C_PF2] & HIRES_MASK_01) | hires_lum(0x40);\
 	art_lookup_new[24] = art_lookup_new[25] = art_lookup_new[26] = art_lookup_new[27] = (ANTIC_cl[C_PF2] & HIRES_MASK_10) | hires_lum(0x80);
 
+static void setup_art_colours_new(void)
+{
+	int i;
+	if (art_new_valid
+	    && art_new_key[0] == ANTIC_cl[C_PF1]
+	    && art_new_key[1] == ANTIC_cl[C_PF2]
+	    && art_new_key[2] == hires_lum(0x40)
+	    && art_new_key[3] == hires_lum(0x80)
+	    && art_new_key[4] == hires_lum(0xc0))
+		return;
+	INIT_ARTIF_NEW
+	for (i = 0; i < 256; i++) {
+#ifdef WORDS_BIGENDIAN
+		art_lookup_new_pairs[i] = ((ULONG) art_lookup_new[i >> 2] << 16) | art_lookup_new[i & 0x3f];
+#else
+		art_lookup_new_pairs[i] = art_lookup_new[i >> 2] | ((ULONG) art_lookup_new[i & 0x3f] << 16);
+#endif
+	}
+	art_new_key[0] = ANTIC_cl[C_PF1];
+	art_new_key[1] = ANTIC_cl[C_PF2];
+	art_new_key[2] = hires_lum(0x40);
+	art_new_key[3] = hires_lum(0x80);
+	art_new_key[4] = hires_lum(0xc0);
+	art_new_valid = TRUE;
+}
+
 #define DO_PMG_HIRES(data) {\
 	const UBYTE *c_pm_scanline_ptr = (const UBYTE *) t_pm_scanline_ptr;\
 	int pm_pixel;\
@@ -1582,7 +1627,7 @@ static void draw_antic_2_artif_new(int nchars, const UBYTE *antic_memptr, UWORD
 	UBYTE screendata = *antic_memptr++;
 	UBYTE chdata;
 	INIT_ANTIC_2
-	INIT_ARTIF_NEW
+	setup_art_colours_new();
 	GET_CHDATA_ANTIC_2
 	screendata_tally = chdata;
 	setup_art_colours();
@@ -2368,7 +2413,7 @@ static void draw_antic_f_artif_new(int nchars, const UBYTE *antic_memptr, UWORD
 {
 	ULONG pmtally;
 	ULONG screendata_tally = *antic_memptr++;
-	INIT_ARTIF_NEW
+	setup_art_colours_new();
 
 	setup_art_colours();
 	CHAR_LOOP_BEGIN
@@ -2683,6 +2728,7 @@ void ANTIC_UpdateArtifacting(void)
 		draw_antic_table[0][0xf] = draw_antic_f_artif_new;
 		art_colour1_new = new_art_colour_table[ANTIC_artif_mode - 1][0];
 		art_colour2_new = new_art_colour_table[ANTIC_artif_mode - 1][1];
+		art_new_valid = FALSE;
 	}
 	else
 #endif
@@ -66,6 +66,9 @@
 #include "cfg.h"
 #include "cpu.h"
 #include "devices.h"
+#if defined(IDE) || defined(PBI_MIO) || defined(PBI_BB)
+#include "diskcache.h"
+#endif
 #include "esc.h"
 #include "gtia.h"
 #include "input.h"
@@ -172,6 +175,9 @@ int Atari800_nframes = 0;
 int Atari800_refresh_rate = 1;
 int Atari800_collisions_in_skipped_frames = FALSE;
 int Atari800_turbo = FALSE;
+int Atari800_fast_boot = FALSE;
+int Atari800_fast_boot_idle = 100;
+int Atari800_fast_boot_frames = 0;
 int Atari800_start_in_monitor = FALSE;
 int Atari800_auto_frameskip = FALSE;
 
@@ -259,6 +265,8 @@ void Atari800_Coldstart(void)
 	CARTRIDGE_ColdStart();
 	/* set Atari OS Coldstart flag */
 	MEMORY_dPutByte(0x244, 1);
+	if (Atari800_fast_boot)
+		Atari800_StartFastBoot();
 	/* handle Option key (disable BASIC in XL/XE)
 	   and Start key (boot from cassette) */
 	GTIA_consol_override = 2;
@@ -275,6 +283,35 @@ void Atari800_Coldstart(void)
 #endif
 }
 
+static int fast_boot_running = FALSE;
+static int fast_boot_start;
+static int fast_boot_last_io;
+
+void Atari800_StartFastBoot(void)
+{
+	if (!fast_boot_running) {
+		fast_boot_running = TRUE;
+		fast_boot_start = Atari800_nframes;
+	}
+	fast_boot_last_io = Atari800_nframes;
+}
+
+int Atari800_FastBootFrame(void)
+{
+	if (!fast_boot_running)
+		return FALSE;
+	if (SIO_last_op_frame - fast_boot_last_io > 0)
+		fast_boot_last_io = SIO_last_op_frame;
+	if (CASSETTE_readable || CASSETTE_writable || BINLOAD_bin_data != NULL)
+		fast_boot_last_io = Atari800_nframes;
+	if (Atari800_nframes - fast_boot_last_io < Atari800_fast_boot_idle)
+		return TRUE;
+	fast_boot_running = FALSE;
+	Atari800_fast_boot_frames = Atari800_nframes - fast_boot_start;
+	Log_print("Fast boot took %d frames", Atari800_fast_boot_frames);
+	return FALSE;
+}
+
 int Atari800_LoadImage(const char *filename, UBYTE *buffer, int nbytes)
 {
 	FILE *f;
@@ -600,6 +637,9 @@ int Atari800_Initialise(int *argc, char *argv[])
 		else if (strcmp(argv[i], "-turbo") == 0) {
 			Atari800_turbo = TRUE;
 		}
+		else if (strcmp(argv[i], "-fastboot") == 0) {
+			Atari800_fast_boot = TRUE;
+		}
 		else {
 			/* parameters that take additional argument follow here */
 			int i_a = (i + 1 < *argc);		/* is argument available? */
@@ -729,6 +769,7 @@ int Atari800_Initialise(int *argc, char *argv[])
 					Log_print("\t-rdevice [<dev>] Enable R: emulation (using serial device <dev>)");
 #endif
 					Log_print("\t-turbo           Run emulated Atari as fast as possible");
+					Log_print("\t-fastboot        Run as fast as possible while booting and loading");
 #ifdef MONITOR_HINTS
 					Log_print("\t-label-file <f>  Load monitor labels from file <f>");
 #endif
@@ -1272,6 +1313,7 @@ static void basic_frame(void)
 
 void Atari800_Frame(void)
 {
+	static int fast_boot = FALSE;
 #ifndef BASIC
 	static int refresh_counter = 0;
 
@@ -1331,6 +1373,21 @@ void Atari800_Frame(void)
 	}
 #endif /* BASIC */
 
+	/* Nothing is displayed or heard while booting fast. */
+	if (Atari800_FastBootFrame()) {
+#ifdef SOUND
+		if (!fast_boot)
+			Sound_Pause();
+#endif
+		fast_boot = TRUE;
+	}
+	else if (fast_boot) {
+#ifdef SOUND
+		Sound_Continue();
+#endif
+		fast_boot = FALSE;
+	}
+
 #ifdef PBI_BB
 	PBI_BB_Frame(); /* just to make the menu key go up automatically */
 #endif
@@ -1338,6 +1395,9 @@ void Atari800_Frame(void)
 	VOTRAXSND_Frame(); /* for the Votrax */
 #endif
 	Devices_Frame();
+#if defined(IDE) || defined(PBI_MIO) || defined(PBI_BB)
+	DISKCACHE_Frame();
+#endif
 #ifndef BASIC
 	INPUT_Frame();
 #endif
@@ -1346,7 +1406,7 @@ void Atari800_Frame(void)
 #ifdef BASIC
 	basic_frame();
 #else /* BASIC */
-	if (++refresh_counter >= Atari800_refresh_rate) {
+	if (!fast_boot && ++refresh_counter >= Atari800_refresh_rate) {
 		refresh_counter = 0;
 #ifdef USE_CURSES
 		curses_clear_screen();
@@ -1412,7 +1472,7 @@ void Atari800_Frame(void)
 			else
 				Atari800_display_screen = FALSE;
 		}
-		else
+		else if (!fast_boot)
 			Atari800_Sync();
 #endif /* BENCHMARK */
 #endif /* LIBATARI800 */
@@ -118,6 +118,20 @@ extern int Atari800_collisions_in_skipped_frames;
 /* Set to TRUE to run emulated Atari as fast as possible */
 extern int Atari800_turbo;
 
+/* Set to TRUE to run every cold start as fast as possible, without
+   display and sound, until no disk, tape or executable file has been read
+   for Atari800_fast_boot_idle frames. */
+extern int Atari800_fast_boot;
+extern int Atari800_fast_boot_idle;
+/* Number of frames the last finished fast boot took. */
+extern int Atari800_fast_boot_frames;
+
+/* Starts a fast boot now, see Atari800_fast_boot. */
+void Atari800_StartFastBoot(void);
+/* Returns TRUE if the next frame is part of a fast boot. Called before
+   every frame; ends the fast boot when loading has stopped. */
+int Atari800_FastBootFrame(void);
+
 /* Set to TRUE to start in the monitor. It's up to each port's
 	main.c to implement this (initially only SDL supports it). */
 extern int Atari800_start_in_monitor;
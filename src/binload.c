@@ -24,9 +24,11 @@
 
 #include "config.h"
 #include <stdio.h>
+#include <stdlib.h>
 
 #include "atari.h"
 #include "binload.h"
+#include "compfile.h"
 #include "cpu.h"
 #include "devices.h"
 #include "esc.h"
@@ -37,7 +39,9 @@
 int BINLOAD_start_binloading = FALSE;
 int BINLOAD_loading_basic = 0;
 int BINLOAD_slow_xex_loading = FALSE;
-FILE *BINLOAD_bin_file = NULL;
+UBYTE *BINLOAD_bin_data = NULL;
+int BINLOAD_bin_size = 0;
+int BINLOAD_bin_pos = 0;
 
 /* These variables are for slow XEX loading only. */
 
@@ -53,13 +57,27 @@ static int init2e3 = FALSE;
 static int segfinished = TRUE;
 int BINLOAD_pause_loading;
 
+int BINLOAD_GetByte(void)
+{
+	if (BINLOAD_bin_pos >= BINLOAD_bin_size)
+		return -1;
+	return BINLOAD_bin_data[BINLOAD_bin_pos++];
+}
+
+void BINLOAD_Close(void)
+{
+	free(BINLOAD_bin_data);
+	BINLOAD_bin_data = NULL;
+	BINLOAD_bin_size = 0;
+	BINLOAD_bin_pos = 0;
+}
+
 /* Read a word from file */
 static int read_word(void)
 {
-	UBYTE buf[2];
-	if (fread(buf, 1, 2, BINLOAD_bin_file) != 2) {
-		fclose(BINLOAD_bin_file);
-		BINLOAD_bin_file = NULL;
+	UBYTE *buf;
+	if (BINLOAD_bin_size - BINLOAD_bin_pos < 2) {
+		BINLOAD_Close();
 		if (BINLOAD_start_binloading) {
 			BINLOAD_start_binloading = FALSE;
 			Log_print("binload: not valid BIN file");
@@ -68,13 +86,15 @@ static int read_word(void)
 		CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
 		return -1;
 	}
+	buf = BINLOAD_bin_data + BINLOAD_bin_pos;
+	BINLOAD_bin_pos += 2;
 	return buf[0] + (buf[1] << 8);
 }
 
 /* Start or continue loading */
 static void loader_cont(void)
 {
-	if (BINLOAD_bin_file == NULL)
+	if (BINLOAD_bin_data == NULL)
 		return;
 	if (BINLOAD_start_binloading) {
 		MEMORY_dPutByte(0x244, 0);
@@ -123,10 +143,9 @@ static void loader_cont(void)
 				instr_elapsed = 0;
 				BINLOAD_wait_active = FALSE;
 			}
-			byte = fgetc(BINLOAD_bin_file);
-			if (byte == EOF) {
-				fclose(BINLOAD_bin_file);
-				BINLOAD_bin_file = NULL;
+			byte = BINLOAD_GetByte();
+			if (byte < 0) {
+				BINLOAD_Close();
 				CPU_regPC = MEMORY_dGetWordAligned(0x2e0);
 				if (MEMORY_dGetByte(0x2e3) != 0xd7) {
 					/* run INIT routine which RTSes directly to RUN routine */
@@ -177,10 +196,9 @@ int BINLOAD_LoaderStart(UBYTE *buffer)
 /* Load BIN file, returns TRUE if ok */
 int BINLOAD_Loader(const char *filename)
 {
-	UBYTE buf[2];
-	if (BINLOAD_bin_file != NULL) {		/* close previously open file */
-		fclose(BINLOAD_bin_file);
-		BINLOAD_bin_file = NULL;
+	UBYTE *buf;
+	if (BINLOAD_bin_data != NULL) {		/* close previously open file */
+		BINLOAD_Close();
 		BINLOAD_loading_basic = 0;
 	}
 	if (Atari800_machine_type == Atari800_MACHINE_5200) {
@@ -190,15 +208,18 @@ int BINLOAD_Loader(const char *filename)
 #endif
 		return FALSE;
 	}
-	BINLOAD_bin_file = fopen(filename, "rb");
-	if (BINLOAD_bin_file == NULL) {	/* open */
+	/* read the whole file, uncompressing it if gzipped */
+	BINLOAD_bin_data = CompFile_ReadFile(filename, &BINLOAD_bin_size);
+	if (BINLOAD_bin_data == NULL) {
 		Log_print("binload: can't open \"%s\"", filename);
 		return FALSE;
 	}
+	BINLOAD_bin_pos = 0;
 	/* Avoid "BOOT ERROR" when loading a BASIC program */
 	if (SIO_drive_status[0] == SIO_NO_DISK)
 		SIO_DisableDrive(1);
-	if (fread(buf, 1, 2, BINLOAD_bin_file) == 2) {
+	if (BINLOAD_bin_size >= 2) {
+		buf = BINLOAD_bin_data;
 		if (buf[0] == 0xff && buf[1] == 0xff) {
 			BINLOAD_start_binloading = TRUE; /* force SIO to call BINLOAD_LoaderStart at boot */
 			Atari800_Coldstart();             /* reboot */
@@ -217,8 +238,7 @@ int BINLOAD_Loader(const char *filename)
 			return TRUE;
 		}
 	}
-	fclose(BINLOAD_bin_file);
-	BINLOAD_bin_file = NULL;
+	BINLOAD_Close();
 	Log_print("binload: \"%s\" not recognized as a DOS or BASIC program", filename);
 	return FALSE;
 }
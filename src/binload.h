@@ -1,10 +1,18 @@
 #ifndef BINLOAD_H_
 #define BINLOAD_H_
 
-#include <stdio.h> /* FILE */
 #include "atari.h" /* UBYTE */
 
-extern FILE *BINLOAD_bin_file;
+/* Contents of the program being loaded (uncompressed if the file was
+   gzipped), or NULL. BINLOAD_bin_pos is the position of the next byte. */
+extern UBYTE *BINLOAD_bin_data;
+extern int BINLOAD_bin_size;
+extern int BINLOAD_bin_pos;
+
+/* Returns the next byte of the program, or -1 at its end. */
+int BINLOAD_GetByte(void);
+/* Frees the program. */
+void BINLOAD_Close(void);
 
 int BINLOAD_Loader(const char *filename);
 extern int BINLOAD_start_binloading;
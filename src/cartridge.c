@@ -30,6 +30,7 @@
 #include "atari.h"
 #include "binload.h" /* BINLOAD_loading_basic */
 #include "cartridge.h"
+#include "compfile.h"
 #include "memory.h"
 #ifdef IDE
 #  include "ide.h"
@@ -86,20 +87,52 @@ CARTRIDGE_image_t CARTRIDGE_piggyback = { CARTRIDGE_NONE, 0, 0, NULL, "" }; /* P
    cartridge is a SpartaDOS X. */
 static CARTRIDGE_image_t *active_cart = &CARTRIDGE_main;
 
+/* Cartridge banks currently copied to $8000-$9FFF and $A000-$BFFF, or NULL
+   if a window holds anything else. MEMORY_mem is flat, so a bank switch has
+   to copy the bank in; this lets it skip windows whose bank didn't change. */
+static UBYTE const *mapped_bank[2];
+
+/* Copies the 8 KB bank SRC to the window at ADDR ($8000 or $A000), unless
+   it's already there. */
+static void CopyBank(UWORD addr, UBYTE const *src)
+{
+	int window = (addr >> 13) & 1;
+	if (mapped_bank[window] != src) {
+		MEMORY_CopyROM(addr, addr + 0x1fff, src);
+		mapped_bank[window] = src;
+	}
+}
+
+void CARTRIDGE_Unmap809F(void)
+{
+	mapped_bank[0] = NULL;
+}
+
+static void Disable809F(void)
+{
+	MEMORY_Cart809fDisable();
+	mapped_bank[0] = NULL;
+}
+
+static void DisableA0BF(void)
+{
+	MEMORY_CartA0bfDisable();
+	mapped_bank[1] = NULL;
+}
+
 /* DB_32, XEGS_32, XEGS_07_64, XEGS_128, XEGS_256, XEGS_512, XEGS_1024,
    SWXEGS_32, SWXEGS_64, SWXEGS_128, SWXEGS_256, SWXEGS_512, SWXEGS_1024 */
-static void set_bank_809F(int main, int old_state)
+static void set_bank_809F(int main)
 {
 	if (active_cart->state & 0x80) {
-		MEMORY_Cart809fDisable();
-		MEMORY_CartA0bfDisable();
+		Disable809F();
+		DisableA0BF();
 	}
 	else {
 		MEMORY_Cart809fEnable();
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0x8000, 0x9fff, active_cart->image + active_cart->state * 0x2000);
-		if (old_state & 0x80)
-			MEMORY_CopyROM(0xa000, 0xbfff, active_cart->image + main);
+		CopyBank(0x8000, active_cart->image + active_cart->state * 0x2000);
+		CopyBank(0xa000, active_cart->image + main);
 	}
 }
 
@@ -107,15 +140,19 @@ static void set_bank_809F(int main, int old_state)
 static void set_bank_XEGS_8F_64(void)
 {
 	if (active_cart->state & 0x08)
-		MEMORY_CopyROM(0x8000, 0x9fff, active_cart->image + (active_cart->state & ~0x08) * 0x2000);
-	else
+		CopyBank(0x8000, active_cart->image + (active_cart->state & ~0x08) * 0x2000);
+	else {
 		/* $8000-$9FFF is left unconnected. */
 		MEMORY_dFillMem(0x8000, 0xff, 0x2000);
+		mapped_bank[0] = NULL;
+	}
 }
 
 /* OSS_034M_16, OSS_043M_16, OSS_M091_16, OSS_8 */
 static void set_bank_A0AF(int main, int old_state)
 {
+	/* The 4 KB banks are not tracked in mapped_bank. */
+	mapped_bank[1] = NULL;
 	if (active_cart->state < 0)
 		MEMORY_CartA0bfDisable();
 	else {
@@ -137,10 +174,10 @@ static void set_bank_A0AF(int main, int old_state)
 static void set_bank_A0BF(int disable_mask, int bank_mask)
 {
 	if (active_cart->state & disable_mask)
-		MEMORY_CartA0bfDisable();
+		DisableA0BF();
 	else {
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0xa000, 0xbfff, active_cart->image + (active_cart->state & bank_mask) * 0x2000);
+		CopyBank(0xa000, active_cart->image + (active_cart->state & bank_mask) * 0x2000);
 	}
 }
 
@@ -149,13 +186,15 @@ static void set_bank_A0BF(int disable_mask, int bank_mask)
 static void set_bank_80BF(void)
 {
 	if (active_cart->state & 0x80) {
-		MEMORY_Cart809fDisable();
-		MEMORY_CartA0bfDisable();
+		Disable809F();
+		DisableA0BF();
 	}
 	else {
+		UBYTE const *bank = active_cart->image + (active_cart->state & 0x7f) * 0x4000;
 		MEMORY_Cart809fEnable();
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0x8000, 0xbfff, active_cart->image + (active_cart->state & 0x7f) * 0x4000);
+		CopyBank(0x8000, bank);
+		CopyBank(0xa000, bank + 0x2000);
 	}
 }
 
@@ -167,27 +206,27 @@ static void set_bank_5200_SUPER(void)
 static void set_bank_SDX_128(void)
 {
 	if (active_cart->state & 8)
-		MEMORY_CartA0bfDisable();
+		DisableA0BF();
 	else {
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0xa000, 0xbfff,
+		CopyBank(0xa000,
 			active_cart->image + ((active_cart->state & 7) + ((active_cart->state & 0x10) >> 1)) * 0x2000);
 	}
 }
 static void set_bank_SIC(int n)
 {
 	if (!(active_cart->state & 0x20))
-		MEMORY_Cart809fDisable();
+		Disable809F();
 	else {
 		MEMORY_Cart809fEnable();
-		MEMORY_CopyROM(0x8000, 0x9fff,
+		CopyBank(0x8000,
 			active_cart->image + (active_cart->state & n) * 0x4000);
 	}
 	if (active_cart->state & 0x40)
-		MEMORY_CartA0bfDisable();
+		DisableA0BF();
 	else {
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0xa000, 0xbfff,
+		CopyBank(0xa000,
 			active_cart->image + (active_cart->state & n) * 0x4000 + 0x2000);
 	}
 }
@@ -196,13 +235,15 @@ static void set_bank_SIC(int n)
 static void set_bank_MEGA_4096(void)
 {
 	if (active_cart->state == 0xff) {
-		MEMORY_Cart809fDisable();
-		MEMORY_CartA0bfDisable();
+		Disable809F();
+		DisableA0BF();
 	}
 	else {
+		UBYTE const *bank = active_cart->image + active_cart->state * 0x4000;
 		MEMORY_Cart809fEnable();
 		MEMORY_CartA0bfEnable();
-		MEMORY_CopyROM(0x8000, 0xbfff, active_cart->image + active_cart->state * 0x4000);
+		CopyBank(0x8000, bank);
+		CopyBank(0xa000, bank + 0x2000);
 	}
 }
 /* Called on a read or write operation to page $D5. Switches banks or
@@ -234,30 +275,30 @@ static void SwitchBank(int old_state)
 	case CARTRIDGE_DB_32:
 	case CARTRIDGE_XEGS_32:
 	case CARTRIDGE_SWXEGS_32:
-		set_bank_809F(0x6000, old_state);
+		set_bank_809F(0x6000);
 		break;
 	case CARTRIDGE_XEGS_07_64:
 	case CARTRIDGE_SWXEGS_64:
-		set_bank_809F(0xe000, old_state);
+		set_bank_809F(0xe000);
 		break;
 	case CARTRIDGE_XEGS_8F_64:
 		set_bank_XEGS_8F_64();
 		break;
 	case CARTRIDGE_XEGS_128:
 	case CARTRIDGE_SWXEGS_128:
-		set_bank_809F(0x1e000, old_state);
+		set_bank_809F(0x1e000);
 		break;
 	case CARTRIDGE_XEGS_256:
 	case CARTRIDGE_SWXEGS_256:
-		set_bank_809F(0x3e000, old_state);
+		set_bank_809F(0x3e000);
 		break;
 	case CARTRIDGE_XEGS_512:
 	case CARTRIDGE_SWXEGS_512:
-		set_bank_809F(0x7e000, old_state);
+		set_bank_809F(0x7e000);
 		break;
 	case CARTRIDGE_XEGS_1024:
 	case CARTRIDGE_SWXEGS_1024:
-		set_bank_809F(0xfe000, old_state);
+		set_bank_809F(0xfe000);
 		break;
 	case CARTRIDGE_ATRAX_DEC_128:
 	case CARTRIDGE_ATMAX_OLD_1024:
@@ -284,12 +325,12 @@ static void SwitchBank(int old_state)
 	case CARTRIDGE_PHOENIX_8:
 	case CARTRIDGE_BLIZZARD_4:
 		if (active_cart->state)
-			MEMORY_CartA0bfDisable();
+			DisableA0BF();
 		break;
 	case CARTRIDGE_BLIZZARD_16:
 		if (active_cart->state) {
-			MEMORY_Cart809fDisable();
-			MEMORY_CartA0bfDisable();
+			Disable809F();
+			DisableA0BF();
 		}
 		break;
 	case CARTRIDGE_SDX_128:
@@ -299,7 +340,7 @@ static void SwitchBank(int old_state)
 	case CARTRIDGE_AST_32:
 		/* Value 0x10000 indicates cartridge enabled. */
 		if (active_cart->state < 0x10000)
-			MEMORY_CartA0bfDisable();
+			DisableA0BF();
 		break;
 	case CARTRIDGE_ULTRACART_32:
 	case CARTRIDGE_BLIZZARD_32:
@@ -341,6 +382,7 @@ static void SwitchBank(int old_state)
    calls SwitchBank(), which maps the rest. */
 static void MapActiveCart(void)
 {
+	mapped_bank[0] = mapped_bank[1] = NULL;
 	if (Atari800_machine_type == Atari800_MACHINE_5200) {
 		MEMORY_SetROM(0x4ff6, 0x4ff9); /* disable Bounty Bob bank switching */
 		MEMORY_SetROM(0x5ff6, 0x5ff9);
@@ -1391,18 +1433,14 @@ void CARTRIDGE_ColdStart(void) {
      CARTRIDGE_SetType() or CARTRIDGE_SetTypeAutoReboot(). */
 static int InsertCartridge(const char *filename, CARTRIDGE_image_t *cart)
 {
-	FILE *fp;
+	UBYTE *data;
 	int len;
 	int type;
-	UBYTE header[16];
 
-	/* open file */
-	fp = fopen(filename, "rb");
-	if (fp == NULL)
+	/* read the whole file, uncompressing it if gzipped */
+	data = CompFile_ReadFile(filename, &len);
+	if (data == NULL)
 		return CARTRIDGE_CANT_OPEN;
-	/* check file length */
-	len = Util_flen(fp);
-	Util_rewind(fp);
 
 	/* Guard against providing cart->filename as parameter. */
 	if (cart->filename != filename)
@@ -1411,12 +1449,8 @@ static int InsertCartridge(const char *filename, CARTRIDGE_image_t *cart)
 
 	/* if full kilobytes, assume it is raw image */
 	if ((len & 0x3ff) == 0) {
-		/* alloc memory and read data */
-		cart->image = (UBYTE *) Util_malloc(len);
-		if (fread(cart->image, 1, len, fp) < len) {
-			Log_print("Error reading cartridge.\n");
-		}
-		fclose(fp);
+		/* the data is the image */
+		cart->image = data;
 		/* find cart type */
 		cart->type = CARTRIDGE_NONE;
 		len >>= 10;	/* number of kilobytes */
@@ -1440,39 +1474,43 @@ static int InsertCartridge(const char *filename, CARTRIDGE_image_t *cart)
 		return CARTRIDGE_BAD_FORMAT;
 	}
 	/* if not full kilobytes, assume it is CART file */
-	if (fread(header, 1, 16, fp) < 16) {
+	if (len < 16) {
 		Log_print("Error reading cartridge.\n");
 	}
-	if ((header[0] == 'C') &&
-		(header[1] == 'A') &&
-		(header[2] == 'R') &&
-		(header[3] == 'T')) {
-		type = (header[4] << 24) |
-			(header[5] << 16) |
-			(header[6] << 8) |
-			header[7];
+	else if ((data[0] == 'C') &&
+		(data[1] == 'A') &&
+		(data[2] == 'R') &&
+		(data[3] == 'T')) {
+		type = (data[4] << 24) |
+			(data[5] << 16) |
+			(data[6] << 8) |
+			data[7];
 		if (type >= 1 && type < CARTRIDGE_TYPE_COUNT) {
 			int checksum;
 			int result;
-			len = CARTRIDGES[type].kb << 10;
+			int size = CARTRIDGES[type].kb << 10;
 			cart->size = CARTRIDGES[type].kb;
-			/* alloc memory and read data */
-			cart->image = (UBYTE *) Util_malloc(len);
-			if (fread(cart->image, 1, len, fp) < len) {
+			/* alloc memory and copy data */
+			cart->image = (UBYTE *) Util_malloc(size);
+			if (len - 16 < size) {
 				Log_print("Error reading cartridge.\n");
+				memset(cart->image + len - 16, 0, size - (len - 16));
+				memcpy(cart->image, data + 16, len - 16);
 			}
-			fclose(fp);
-			checksum = (header[8] << 24) |
-				(header[9] << 16) |
-				(header[10] << 8) |
-				header[11];
+			else
+				memcpy(cart->image, data + 16, size);
+			checksum = (data[8] << 24) |
+				(data[9] << 16) |
+				(data[10] << 8) |
+				data[11];
+			free(data);
 			cart->type = type;
-			result = checksum == CARTRIDGE_Checksum(cart->image, len) ? 0 : CARTRIDGE_BAD_CHECKSUM;
+			result = checksum == CARTRIDGE_Checksum(cart->image, size) ? 0 : CARTRIDGE_BAD_CHECKSUM;
 			InitCartridge(cart);
 			return result;
 		}
 	}
-	fclose(fp);
+	free(data);
 	return CARTRIDGE_BAD_FORMAT;
 }
 
@@ -72,6 +72,10 @@ void CARTRIDGE_Remove_Second(void);
 /* Called on system coldstart. Resets the states of mounted cartridges. */
 void CARTRIDGE_ColdStart(void);
 
+/* Must be called when something other than the cartridge code changes
+   $8000-$9FFF, so that the next bank switch copies the bank in again. */
+void CARTRIDGE_Unmap809F(void);
+
 UBYTE CARTRIDGE_GetByte(UWORD addr, int no_side_effects);
 void CARTRIDGE_PutByte(UWORD addr, UBYTE byte);
 void CARTRIDGE_StateSave(void);
@@ -59,6 +59,17 @@ static UBYTE pending_serin_byte = 0xff;
 /* Byte most recently loaded from tape; will be accessed by SIO_GetByte(). */
 static UBYTE serin_byte = 0xff;
 
+/* Number of consecutive reads of the serial input line, each within a
+   scanline of the previous one, and scanlines since the last read. A
+   program polling the line that often is waiting for a record to start. */
+static int line_polls = 0;
+static int lines_since_poll = 0;
+
+/* In accelerated mode, the rest of a gap before a standard record is cut to
+   ACCEL_GAP_TICKS (10 ms) once ACCEL_POLLS polls were counted. */
+#define ACCEL_POLLS 16
+#define ACCEL_GAP_TICKS (10 * 1790)
+
 char CASSETTE_filename[FILENAME_MAX];
 CASSETTE_status_t CASSETTE_status = CASSETTE_STATUS_NONE;
 int CASSETTE_write_protect = FALSE;
@@ -73,6 +84,7 @@ static int cassette_motor = 0;
 int CASSETTE_hold_start_on_reboot = 0;
 int CASSETTE_hold_start = 0;
 int CASSETTE_press_space = 0;
+int CASSETTE_accel = FALSE;
 /* Indicates whether the tape has ended. During saving the value is always 0;
    during loading it is equal to (CASSETTE_GetPosition() >= CASSETTE_GetSize()). */
 static int eof_of_tape = 0;
@@ -106,6 +118,12 @@ int CASSETTE_ReadConfig(char *string, char *ptr)
 			return FALSE;
 		CASSETTE_write_protect = value;
 	}
+	else if (strcmp(string, "CASSETTE_ACCEL") == 0) {
+		int value = Util_sscanbool(ptr);
+		if (value == -1)
+			return FALSE;
+		CASSETTE_accel = value;
+	}
 	else return FALSE;
 	return TRUE;
 }
@@ -115,6 +133,7 @@ void CASSETTE_WriteConfig(FILE *fp)
 	fprintf(fp, "CASSETTE_FILENAME=%s\n", CASSETTE_filename);
 	fprintf(fp, "CASSETTE_LOADED=%d\n", CASSETTE_status != CASSETTE_STATUS_NONE);
 	fprintf(fp, "CASSETTE_WRITE_PROTECT=%d\n", CASSETTE_write_protect);
+	fprintf(fp, "CASSETTE_ACCEL=%d\n", CASSETTE_accel);
 }
 
 int CASSETTE_Initialise(int *argc, char *argv[])
@@ -148,11 +167,17 @@ int CASSETTE_Initialise(int *argc, char *argv[])
 		}
 		else if (strcmp(argv[i], "-tape-readonly") == 0)
 			protect = TRUE;
+		else if (strcmp(argv[i], "-tape-accel") == 0)
+			CASSETTE_accel = TRUE;
+		else if (strcmp(argv[i], "-no-tape-accel") == 0)
+			CASSETTE_accel = FALSE;
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
 				Log_print("\t-tape <file>      Insert cassette image");
 				Log_print("\t-boottape <file>  Insert cassette image and boot it");
 				Log_print("\t-tape-readonly    Mark the attached cassette image as read-only");
+				Log_print("\t-tape-accel       Load standard tape records faster without SIO patch");
+				Log_print("\t-no-tape-accel    Load all tape records at their real speed");
 			}
 			argv[j++] = argv[i];
 		}
@@ -293,6 +318,16 @@ int CASSETTE_IOLineStatus(void)
 		return 1;
 	}
 
+	if (lines_since_poll > 1)
+		line_polls = 1;
+	else if (line_polls < ACCEL_POLLS)
+		line_polls++;
+	lines_since_poll = 0;
+	/* A program that is busy between records (eg. with the motor kept
+	   running) doesn't poll the line, so its gaps are left intact. */
+	if (CASSETTE_accel && passing_gap && line_polls >= ACCEL_POLLS
+	    && event_time_left > ACCEL_GAP_TICKS && IMG_TAPE_StandardRecord(cassette_file))
+		event_time_left = ACCEL_GAP_TICKS;
 	return IMG_TAPE_SerinStatus(cassette_file, event_time_left);
 }
 
@@ -365,7 +400,7 @@ static int CassetteRead(int num_ticks)
 			/* If POKEY is in reset state, no serial I/O occurs. */
 			pending_serin = (POKEY_SKCTL & 0x03) != 0;
 
-			if (!IMG_TAPE_Read(cassette_file, &length, &passing_gap, &pending_serin_byte)) {
+			if (!IMG_TAPE_Read(cassette_file, &length, &passing_gap, &pending_serin_byte, CASSETTE_accel)) {
 				eof_of_tape = 1;
 				UpdateFlags();
 				return loaded;
@@ -380,6 +415,8 @@ static int CassetteRead(int num_ticks)
 
 int CASSETTE_AddScanLine(void)
 {
+	if (lines_since_poll < 2)
+		lines_since_poll++;
 	/* increment elapsed cassette time */
 	if (CASSETTE_record) {
 		CassetteWrite(114);
@@ -35,6 +35,13 @@ extern int CASSETTE_hold_start;
 extern int CASSETTE_hold_start_on_reboot; /* preserve hold_start after reboot */
 extern int CASSETTE_press_space;
 
+/* Set to TRUE to load standard records (see IMG_TAPE_StandardRecord())
+   faster when the SIO patch is off: their data bytes arrive every 10
+   scanlines instead of at the tape's baudrate, and the gap before them is
+   cut short as soon as a program polls the serial input line waiting for
+   the record. Other records load at their real speed. */
+extern int CASSETTE_accel;
+
 /* Is cassette file write-protected? Don't change directly, use CASSETTE_ToggleWriteProtect(). */
 extern int CASSETTE_write_protect;
 /* Switches RO/RW. Fails with FALSE if the tape cannot be switched to RW. */
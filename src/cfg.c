@@ -35,6 +35,7 @@
 #include "memory.h"
 #include "pbi.h"
 #include "rtime.h"
+#include "sio.h"
 #include "sysrom.h"
 #ifdef XEP80_EMULATION
 #include "xep80.h"
@@ -46,6 +47,7 @@
 #include "bit3.h"
 #endif
 #include "platform.h"
+#include "mzpokeysnd.h"
 #include "pokeysnd.h"
 #include "ui.h"
 #include "util.h"
@@ -212,6 +214,16 @@ int CFG_LoadConfig(const char *alternate_config_filename)
 			else if (strcmp(string, "ENABLE_NEW_POKEY") == 0) {
 #ifdef SOUND
 				POKEYSND_enable_new_pokey = Util_sscanbool(ptr);
+#endif /* SOUND */
+			}
+			else if (strcmp(string, "NEW_POKEY_FIXED_POINT") == 0) {
+#ifdef SOUND
+				MZPOKEYSND_fixed_point = Util_sscanbool(ptr);
+#endif /* SOUND */
+			}
+			else if (strcmp(string, "NEW_POKEY_FILTER_CACHE") == 0) {
+#ifdef SOUND
+				Util_strlcpy(MZPOKEYSND_filter_cache_dir, ptr, FILENAME_MAX);
 #endif /* SOUND */
 			}
 			else if (strcmp(string, "STEREO_POKEY") == 0) {
@@ -304,6 +316,8 @@ int CFG_LoadConfig(const char *alternate_config_filename)
 			}
 			else if (CASSETTE_ReadConfig(string, ptr)) {
 			}
+			else if (SIO_ReadConfig(string, ptr)) {
+			}
 			else if (RTIME_ReadConfig(string, ptr)) {
 			}
 #ifdef XEP80_EMULATION
@@ -438,6 +452,8 @@ int CFG_WriteConfig(void)
 
 #ifdef SOUND
 	fprintf(fp, "ENABLE_NEW_POKEY=%d\n", POKEYSND_enable_new_pokey);
+	fprintf(fp, "NEW_POKEY_FIXED_POINT=%d\n", MZPOKEYSND_fixed_point);
+	fprintf(fp, "NEW_POKEY_FILTER_CACHE=%s\n", MZPOKEYSND_filter_cache_dir);
 #ifdef STEREO_SOUND
 	fprintf(fp, "STEREO_POKEY=%d\n", POKEYSND_stereo_enabled);
 #endif
@@ -459,6 +475,7 @@ int CFG_WriteConfig(void)
 	PBI_WriteConfig(fp);
 	CARTRIDGE_WriteConfig(fp);
 	CASSETTE_WriteConfig(fp);
+	SIO_WriteConfig(fp);
 	RTIME_WriteConfig(fp);
 #ifdef XEP80_EMULATION
 	XEP80_WriteConfig(fp);
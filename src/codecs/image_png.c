@@ -32,6 +32,7 @@
 #include "colours.h"
 #include "util.h"
 #include "log.h"
+#include "palette_expand.h"
 #include "file_export.h"
 #include "codecs/image.h"
 #include "codecs/image_png.h"
@@ -123,22 +124,16 @@ static int PNG_SaveScreen(FILE *fp, UBYTE *ptr1, UBYTE *ptr2)
 	}
 	else {
 		png_bytep ptr3;
-		int x;
 		int y;
 		ptr1 += (Screen_WIDTH * image_codec_top_margin) + image_codec_left_margin;
 		ptr2 += (Screen_WIDTH * image_codec_top_margin) + image_codec_left_margin;
 		ptr3 = (png_bytep) Util_malloc(3 * image_codec_width * image_codec_height);
 		for (y = 0; y < image_codec_height; y++) {
 			rows[y] = ptr3;
-			for (x = 0; x < image_codec_width; x++) {
-				*ptr3++ = (png_byte) ((Colours_GetR(*ptr1) + Colours_GetR(*ptr2)) >> 1);
-				*ptr3++ = (png_byte) ((Colours_GetG(*ptr1) + Colours_GetG(*ptr2)) >> 1);
-				*ptr3++ = (png_byte) ((Colours_GetB(*ptr1) + Colours_GetB(*ptr2)) >> 1);
-				ptr1++;
-				ptr2++;
-			}
-			ptr1 += Screen_WIDTH - image_codec_width;
-			ptr2 += Screen_WIDTH - image_codec_width;
+			PALETTE_EXPAND_LineRGB24(ptr3, ptr1, ptr2, image_codec_width, Colours_table);
+			ptr3 += 3 * image_codec_width;
+			ptr1 += Screen_WIDTH;
+			ptr2 += Screen_WIDTH;
 		}
 	}
 	png_set_rows(png_ptr, info_ptr, rows);
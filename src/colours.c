@@ -182,6 +182,9 @@ static void UpdatePalette(void)
 
 void Colours_Update(void)
 {
+#if SUPPORTS_PLATFORM_DISPLAYCHANGE
+	PLATFORM_BeforeDisplayChange();
+#endif
 	UpdatePalette();
 #if SUPPORTS_PLATFORM_PALETTEUPDATE
 	PLATFORM_PaletteUpdate();
@@ -36,11 +36,66 @@
 #include "log.h"
 #include "util.h"
 
+/* Output of the decompressors: a file or a growing memory buffer. */
+typedef struct {
+	FILE *fp; /* NULL when writing to memory */
+	UBYTE *buf;
+	int size; /* length of the data in buf */
+	int alloc;
+	int pos;
+} Sink;
+
+static void sink_init(Sink *sink, FILE *fp)
+{
+	sink->fp = fp;
+	sink->buf = NULL;
+	sink->size = 0;
+	sink->alloc = 0;
+	sink->pos = 0;
+}
+
+static int sink_write(Sink *sink, const void *data, int size)
+{
+	if (sink->fp != NULL)
+		return (int) fwrite(data, 1, size, sink->fp) == size;
+	if (sink->pos + size > sink->alloc) {
+		sink->alloc = (sink->pos + size) * 2;
+		if (sink->alloc < 65536)
+			sink->alloc = 65536;
+		sink->buf = (UBYTE *) Util_realloc(sink->buf, sink->alloc);
+	}
+	memcpy(sink->buf + sink->pos, data, size);
+	sink->pos += size;
+	if (sink->pos > sink->size)
+		sink->size = sink->pos;
+	return TRUE;
+}
+
+static void sink_rewind(Sink *sink)
+{
+	if (sink->fp != NULL)
+		Util_rewind(sink->fp);
+	else
+		sink->pos = 0;
+}
+
+/* Returns the data written to a memory sink, or frees it if !OK. */
+static UBYTE *sink_result(Sink *sink, int ok, int *size)
+{
+	if (!ok) {
+		free(sink->buf);
+		return NULL;
+	}
+	if (sink->buf == NULL)
+		sink->buf = (UBYTE *) Util_malloc(1);
+	*size = sink->size;
+	return sink->buf;
+}
+
+
 /* GZ decompression ------------------------------------------------------ */
 
-/* Opens a GZIP compressed file and decompresses its contents to outfp.
-   Returns TRUE on success. */
-int CompFile_ExtractGZ(const char *infilename, FILE *outfp)
+static int extract_gz(const char *infilename, Sink *out)
 {
 #ifndef HAVE_LIBZ
 	Log_print("This executable cannot decompress ZLIB files");
@@ -59,7 +114,7 @@ int CompFile_ExtractGZ(const char *infilename, FILE *outfp)
 	do {
 		result = gzread(gzf, buf, UNCOMPRESS_BUFFER_SIZE);
 		if (result > 0) {
-			if ((int) fwrite(buf, 1, result, outfp) != result)
+			if (!sink_write(out, buf, result))
 				result = -1;
 		}
 	} while (result == UNCOMPRESS_BUFFER_SIZE);
@@ -69,6 +124,48 @@ int CompFile_ExtractGZ(const char *infilename, FILE *outfp)
 #endif	/* HAVE_LIBZ */
 }
 
+/* Opens a GZIP compressed file and decompresses its contents to outfp.
+   Returns TRUE on success. */
+int CompFile_ExtractGZ(const char *infilename, FILE *outfp)
+{
+	Sink out;
+	sink_init(&out, outfp);
+	return extract_gz(infilename, &out);
+}
+
+UBYTE *CompFile_ExtractGZToMemory(const char *infilename, int *size)
+{
+	Sink out;
+	sink_init(&out, NULL);
+	return sink_result(&out, extract_gz(infilename, &out), size);
+}
+
+UBYTE *CompFile_ReadFile(const char *filename, int *size)
+{
+	UBYTE *buf;
+	int len;
+	int c;
+	FILE *fp = fopen(filename, "rb");
+	if (fp == NULL)
+		return NULL;
+	c = fgetc(fp);
+	if (c == 0x1f && fgetc(fp) == 0x8b) {
+		fclose(fp);
+		return CompFile_ExtractGZToMemory(filename, size);
+	}
+	len = Util_flen(fp);
+	Util_rewind(fp);
+	buf = (UBYTE *) Util_malloc(len > 0 ? len : 1);
+	if ((int) fread(buf, 1, len, fp) != len) {
+		fclose(fp);
+		free(buf);
+		return NULL;
+	}
+	fclose(fp);
+	*size = len;
+	return buf;
+}
+
 
 /* DCM decompression ----------------------------------------------------- */
 
@@ -90,13 +187,8 @@ static int fload(void *buf, int size, FILE *fp)
 	return (int) fread(buf, 1, size, fp) == size;
 }
 
-static int fsave(void *buf, int size, FILE *fp)
-{
-	return (int) fwrite(buf, 1, size, fp) == size;
-}
-
 typedef struct {
-	FILE *fp;
+	Sink *out;
 	int sectorcount;
 	int sectorsize;
 	int current_sector;
@@ -122,12 +214,12 @@ static int write_atr_header(const ATR_Info *pai)
 	header.seccounthi = (UBYTE) (paras >> 8);
 	header.hiseccountlo = (UBYTE) (paras >> 16);
 	header.hiseccounthi = (UBYTE) (paras >> 24);
-	return fsave(&header, sizeof(header), pai->fp);
+	return sink_write(pai->out, &header, sizeof(header));
 }
 
 static int write_atr_sector(ATR_Info *pai, UBYTE *buf)
 {
-	return fsave(buf, pai->current_sector++ <= 3 ? 128 : pai->sectorsize, pai->fp);
+	return sink_write(pai->out, buf, pai->current_sector++ <= 3 ? 128 : pai->sectorsize);
 }
 
 static int pad_till_sector(ATR_Info *pai, int till_sector)
@@ -233,7 +325,7 @@ static int dcm_pass(FILE *infp, ATR_Info *pai)
 	}
 }
 
-int CompFile_DCMtoATR(FILE *infp, FILE *outfp)
+static int dcm_to_atr(FILE *infp, Sink *out)
 {
 	int archive_type;
 	int archive_flags;
@@ -252,7 +344,7 @@ int CompFile_DCMtoATR(FILE *infp, FILE *outfp)
 			Log_print("It seems that DCMs of a multi-file archive have been combined in wrong order");
 		return FALSE;
 	}
-	ai.fp = outfp;
+	ai.out = out;
 	ai.current_sector = 1;
 	switch ((archive_flags >> 5) & 3) {
 	case 0:
@@ -306,6 +398,20 @@ int CompFile_DCMtoATR(FILE *infp, FILE *outfp)
 		return pad_till_sector(&ai, ai.sectorcount + 1);
 	/* more sectors written: update ATR header */
 	ai.sectorcount = last_sector;
-	Util_rewind(outfp);
+	sink_rewind(out);
 	return write_atr_header(&ai);
 }
+
+int CompFile_DCMtoATR(FILE *infp, FILE *outfp)
+{
+	Sink out;
+	sink_init(&out, outfp);
+	return dcm_to_atr(infp, &out);
+}
+
+UBYTE *CompFile_DCMtoATRMemory(FILE *infp, int *size)
+{
+	Sink out;
+	sink_init(&out, NULL);
+	return sink_result(&out, dcm_to_atr(infp, &out), size);
+}
@@ -2,8 +2,19 @@
 #define COMPFILE_H_
 
 #include <stdio.h>  /* FILE */
+#include "atari.h"  /* UBYTE */
 
 int CompFile_ExtractGZ(const char *infilename, FILE *outfp);
 int CompFile_DCMtoATR(FILE *infp, FILE *outfp);
 
+/* Like the above, but decompress to a buffer allocated with malloc().
+   Set *SIZE to the length of the data. Return NULL on error. */
+UBYTE *CompFile_ExtractGZToMemory(const char *infilename, int *size);
+UBYTE *CompFile_DCMtoATRMemory(FILE *infp, int *size);
+
+/* Reads the whole file to a buffer allocated with malloc(), uncompressing
+   it if it's gzipped. Sets *SIZE to the length of the data. Returns NULL
+   on error. */
+UBYTE *CompFile_ReadFile(const char *filename, int *size);
+
 #endif /* COMPFILE_H_ */
@@ -234,49 +234,123 @@ static int match(const char *pattern, const char *filename)
 
 static char dir_path[FILENAME_MAX];
 static char filename_pattern[FILENAME_MAX];
-static DIR *dp = NULL;
+
+/* Names of the entries of the directory, NUL-terminated one after another.
+   DOS listings and wildcard commands open the same directory over and over,
+   so the names are read once and kept while the directory (device and inode)
+   and its modification time are unchanged. */
+static char *dir_names = NULL;
+static size_t dir_names_len = 0;
+static size_t dir_names_alloc = 0;
+static size_t dir_names_next; /* offset of the next name for Devices_ReadDir */
+static int dir_names_valid = FALSE;
+#ifdef HAVE_STAT
+static char dir_names_path[FILENAME_MAX];
+static dev_t dir_names_dev;
+static ino_t dir_names_ino;
+static time_t dir_names_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+static long dir_names_mtime_nsec;
+#endif
+
+/* Resolution of directory modification times to allow for: FAT stores them
+   with 2 seconds granularity. */
+#define DIR_MTIME_GRANULARITY 2
+
+/* Returns TRUE if STATUS describes the directory whose names are cached,
+   unmodified. */
+static int SameDirNames(struct stat const *status)
+{
+	return status->st_dev == dir_names_dev && status->st_ino == dir_names_ino
+	    && status->st_mtime == dir_names_mtime
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+	    && status->st_mtim.tv_nsec == dir_names_mtime_nsec
+#endif
+	    && strcmp(dir_path, dir_names_path) == 0;
+}
+#endif
+
+static int ReadDirNames(void)
+{
+	DIR *dp;
+	struct dirent *entry;
+	dp = opendir(dir_path);
+	if (dp == NULL)
+		return FALSE;
+	dir_names_len = 0;
+	while ((entry = readdir(dp)) != NULL) {
+		size_t len;
+		/* never match "." and ".." */
+		if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+			continue;
+		len = strlen(entry->d_name) + 1;
+		if (dir_names_len + len > dir_names_alloc) {
+			dir_names_alloc = 2 * (dir_names_len + len);
+			dir_names = (char *) Util_realloc(dir_names, dir_names_alloc);
+		}
+		memcpy(dir_names + dir_names_len, entry->d_name, len);
+		dir_names_len += len;
+	}
+	closedir(dp);
+	return TRUE;
+}
 
 static int Devices_OpenDir(const char *filename)
 {
+#ifdef HAVE_STAT
+	struct stat status;
+	int have_status;
+#endif
 	Util_splitpath(filename, dir_path, filename_pattern);
-	if (dp != NULL)
-		closedir(dp);
-	dp = opendir(dir_path);
-	return dp != NULL;
+	dir_names_next = 0;
+#ifdef HAVE_STAT
+	have_status = stat(dir_path, &status) == 0;
+	if (dir_names_valid && have_status && SameDirNames(&status))
+		return TRUE;
+#endif
+	dir_names_valid = FALSE;
+	if (!ReadDirNames())
+		return FALSE;
+#ifdef HAVE_STAT
+	/* A change soon after the read might not change the modification time,
+	   whose resolution may be coarse, so keep the names only if the
+	   directory was last modified well in the past. */
+	if (have_status && time(NULL) - status.st_mtime > DIR_MTIME_GRANULARITY) {
+		strcpy(dir_names_path, dir_path);
+		dir_names_dev = status.st_dev;
+		dir_names_ino = status.st_ino;
+		dir_names_mtime = status.st_mtime;
+#ifdef HAVE_STRUCT_STAT_ST_MTIM_TV_NSEC
+		dir_names_mtime_nsec = status.st_mtim.tv_nsec;
+#endif
+		dir_names_valid = TRUE;
+	}
+#endif
+	return TRUE;
 }
 
 static int Devices_ReadDir(char *fullpath, char *filename, int *isdir,
                           int *readonly, int *size, char *timetext)
 {
-	struct dirent *entry;
+	const char *name;
 	char temppath[FILENAME_MAX];
 #ifdef HAVE_STAT
 	struct stat status;
 #endif
 	for (;;) {
-		entry = readdir(dp);
-		if (entry == NULL) {
-			closedir(dp);
-			dp = NULL;
+		if (dir_names_next >= dir_names_len)
 			return FALSE;
-		}
-		if (entry->d_name[0] == '.') {
-			/* don't match Unix hidden files unless specifically requested */
-			if (filename_pattern[0] != '.')
-				continue;
-			/* never match "." */
-			if (entry->d_name[1] == '\0')
-				continue;
-			/* never match ".." */
-			if (entry->d_name[1] == '.' && entry->d_name[2] == '\0')
-				continue;
-		}
-		if (match(filename_pattern, entry->d_name))
+		name = dir_names + dir_names_next;
+		dir_names_next += strlen(name) + 1;
+		/* don't match Unix hidden files unless specifically requested */
+		if (name[0] == '.' && filename_pattern[0] != '.')
+			continue;
+		if (match(filename_pattern, name))
 			break;
 	}
 	if (filename != NULL)
-		strcpy(filename, entry->d_name);
-	Util_catpath(temppath, dir_path, entry->d_name);
+		strcpy(filename, name);
+	Util_catpath(temppath, dir_path, name);
 	if (fullpath != NULL)
 		strcpy(fullpath, temppath);
 #ifdef HAVE_STAT
@@ -500,6 +574,9 @@ char Devices_h_exe_path[FILENAME_MAX] = DEFAULT_H_PATH;
    only Util_DIR_SEP_CHAR can be used as a directory separator here */
 char Devices_h_current_dir[4][FILENAME_MAX];
 
+/* size of the stdio buffer of files open via H: device */
+#define H_BUFFER_SIZE 0x10000
+
 /* stream open via H: device per IOCB */
 static FILE *h_fp[8] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
 
@@ -838,6 +915,7 @@ static void Devices_H_Open(void)
 		   we want to support LF, CR/LF and CR, not only native EOLs */
 		fp = Util_fopen(host_path, "rb", h_tmpbuf[h_iocb]);
 		if (fp != NULL) {
+			setvbuf(fp, NULL, _IOFBF, H_BUFFER_SIZE);
 			CPU_regY = 1;
 			CPU_ClrN;
 		}
@@ -956,6 +1034,7 @@ static void Devices_H_Open(void)
 			}
 		}
 		if (fp != NULL) {
+			setvbuf(fp, NULL, _IOFBF, H_BUFFER_SIZE);
 			CPU_regY = 1;
 			CPU_ClrN;
 		}
@@ -986,6 +1065,58 @@ static void Devices_H_Close(void)
 	CPU_ClrN;
 }
 
+/* Reads the next byte of the stream open on h_iocb into *BYTE, converting
+   EOLs in text mode. Returns 1, 3 if the next read will yield EOF, or 136
+   (end of file). */
+static int Devices_H_GetByte(UBYTE *byte)
+{
+	FILE *fp = h_fp[h_iocb];
+	int ch;
+	if (h_lastop[h_iocb] != 'r') {
+		if (h_lastop[h_iocb] == 'w')
+			fseek(fp, 0, SEEK_CUR);
+		h_lastbyte[h_iocb] = fgetc(fp);
+		h_lastop[h_iocb] = 'r';
+	}
+	ch = h_lastbyte[h_iocb];
+	if (ch == EOF)
+		return 136; /* end of file */
+	if (h_textmode[h_iocb]) {
+		switch (ch) {
+		case 0x0d:
+			h_wascr[h_iocb] = TRUE;
+			ch = 0x9b;
+			break;
+		case 0x0a:
+			if (h_wascr[h_iocb]) {
+				/* ignore LF next to CR */
+				ch = fgetc(fp);
+				if (ch == EOF) {
+					h_lastbyte[h_iocb] = EOF;
+					return 136; /* end of file */
+				}
+				if (ch == 0x0d) {
+					h_wascr[h_iocb] = TRUE;
+					ch = 0x9b;
+				}
+				else
+					h_wascr[h_iocb] = FALSE;
+			}
+			else
+				ch = 0x9b;
+			break;
+		default:
+			h_wascr[h_iocb] = FALSE;
+			break;
+		}
+	}
+	*byte = (UBYTE) ch;
+	/* [OSMAN] p. 79: Status should be 3 if next read would yield EOF.
+	   But to set the stream's EOF flag, we need to read the next byte. */
+	h_lastbyte[h_iocb] = fgetc(fp);
+	return feof(fp) ? 3 : 1;
+}
+
 static void Devices_H_Read(void)
 {
 	if (devbug)
@@ -993,58 +1124,31 @@ static void Devices_H_Read(void)
 	if (!Devices_GetIOCB())
 		return;
 	if (h_fp[h_iocb] != NULL) {
-		int ch;
-		if (h_lastop[h_iocb] != 'r') {
-			if (h_lastop[h_iocb] == 'w')
-				fseek(h_fp[h_iocb], 0, SEEK_CUR);
-			h_lastbyte[h_iocb] = fgetc(h_fp[h_iocb]);
-			h_lastop[h_iocb] = 'r';
-		}
-		ch = h_lastbyte[h_iocb];
-		if (ch != EOF) {
-			if (h_textmode[h_iocb]) {
-				switch (ch) {
-				case 0x0d:
-					h_wascr[h_iocb] = TRUE;
-					ch = 0x9b;
-					break;
-				case 0x0a:
-					if (h_wascr[h_iocb]) {
-						/* ignore LF next to CR */
-						ch = fgetc(h_fp[h_iocb]);
-						if (ch != EOF) {
-							if (ch == 0x0d) {
-								h_wascr[h_iocb] = TRUE;
-								ch = 0x9b;
-							}
-							else
-								h_wascr[h_iocb] = FALSE;
-						}
-						else {
-							CPU_regY = 136; /* end of file */
-							CPU_SetN;
-							break;
-						}
-					}
-					else
-						ch = 0x9b;
-					break;
-				default:
-					h_wascr[h_iocb] = FALSE;
-					break;
-				}
+		UBYTE byte = 0;
+		int status = Devices_H_GetByte(&byte);
+		if (MEMORY_dGetByte(Devices_ICCOMZ) == 7) {
+			/* CIO's GET CHARACTERS calls the handler for every byte.
+			   Store all but the last byte of the buffer here, advancing
+			   the buffer address and length in ZIOCB as CIO's loop would,
+			   and return the last byte to CIO. */
+			UWORD addr = MEMORY_dGetWordAligned(Devices_ICBALZ);
+			UWORD len = MEMORY_dGetWordAligned(Devices_ICBLLZ);
+			while (len > 1 && status < 128) {
+				MEMORY_PutByte(addr, byte);
+				addr++;
+				len--;
+				status = Devices_H_GetByte(&byte);
 			}
-			CPU_regA = (UBYTE) ch;
-			/* [OSMAN] p. 79: Status should be 3 if next read would yield EOF.
-			   But to set the stream's EOF flag, we need to read the next byte. */
-			h_lastbyte[h_iocb] = fgetc(h_fp[h_iocb]);
-			CPU_regY = feof(h_fp[h_iocb]) ? 3 : 1;
+			MEMORY_dPutWordAligned(Devices_ICBALZ, addr);
+			MEMORY_dPutWordAligned(Devices_ICBLLZ, len);
+		}
+		CPU_regY = status;
+		if (status < 128) {
+			CPU_regA = byte;
 			CPU_ClrN;
 		}
-		else {
-			CPU_regY = 136; /* end of file */
+		else
 			CPU_SetN;
-		}
 	}
 	else {
 		CPU_regY = 136; /* end of file; XXX: this seems to be what Atari DOSes return */
@@ -2266,17 +2370,11 @@ static void Devices_GetBasicCommand(void)
 
 static void Devices_OpenBasicFile(void)
 {
-	if (BINLOAD_bin_file != NULL) {
+	if (BINLOAD_bin_data != NULL) {
 		if (BINLOAD_loading_basic == BINLOAD_LOADING_BASIC_LISTED) {
 			/* determine its type now rather than during the loading */
-			unsigned char buf[2];
-			size_t buf_read;
-
-			fseek(BINLOAD_bin_file, 0, SEEK_END);
-			fseek(BINLOAD_bin_file, -2, SEEK_CUR);
-
-			buf_read = fread(buf, sizeof(buf[0]), 2, BINLOAD_bin_file);
-			if (buf_read == 2) {
+			if (BINLOAD_bin_size >= 2) {
+				const UBYTE *buf = BINLOAD_bin_data + BINLOAD_bin_size - 2;
 				/* simple heuristics - look at the last and possibly one before last character */
 				if (buf[1] == 0x9b) {
 					BINLOAD_loading_basic = BINLOAD_LOADING_BASIC_LISTED_ATARI;
@@ -2291,7 +2389,7 @@ static void Devices_OpenBasicFile(void)
 			}
 		}
 
-		fseek(BINLOAD_bin_file, 0, SEEK_SET);
+		BINLOAD_bin_pos = 0;
 		ESC_AddEscRts(ehclos_addr, ESC_EHCLOS, Devices_CloseBasicFile);
 		ESC_AddEscRts(ehread_addr, ESC_EHREAD, Devices_ReadBasicFile);
 		CPU_regY = 1;
@@ -2304,9 +2402,9 @@ static void Devices_OpenBasicFile(void)
 
 static void Devices_ReadBasicFile(void)
 {
-	if (BINLOAD_bin_file != NULL) {
-		int ch = fgetc(BINLOAD_bin_file);
-		if (ch == EOF) {
+	if (BINLOAD_bin_data != NULL) {
+		int ch = BINLOAD_GetByte();
+		if (ch < 0) {
 			CPU_regY = 136;
 			CPU_SetN;
 			return;
@@ -2327,8 +2425,8 @@ static void Devices_ReadBasicFile(void)
 			break;
 		case BINLOAD_LOADING_BASIC_LISTED_CRLF:
 			if (ch == 0x0a) {
-				ch = fgetc(BINLOAD_bin_file);
-				if (ch == EOF) {
+				ch = BINLOAD_GetByte();
+				if (ch < 0) {
 					CPU_regY = 136;
 					CPU_SetN;
 					return;
@@ -2352,9 +2450,8 @@ static void Devices_ReadBasicFile(void)
 
 static void Devices_CloseBasicFile(void)
 {
-	if (BINLOAD_bin_file != NULL) {
-		fclose(BINLOAD_bin_file);
-		BINLOAD_bin_file = NULL;
+	if (BINLOAD_bin_data != NULL) {
+		BINLOAD_Close();
 		/* "RUN" ENTERed program */
 		if (BINLOAD_loading_basic != 0 && BINLOAD_loading_basic != BINLOAD_LOADING_BASIC_SAVED) {
 			ready_ptr = ready_prompt;
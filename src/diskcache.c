@@ -0,0 +1,281 @@
+/*
+ * diskcache.c - block cache for hard disk images
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#define _XOPEN_SOURCE 600
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "atari.h"
+#include "diskcache.h"
+#include "log.h"
+#include "util.h"
+
+#if defined(HAVE_WINDOWS_H)
+#  define fseeko fseeko64
+#  define ftello ftello64
+#elif !defined(HAVE_FSEEKO)
+#  define fseeko(f, offset, whence) fseek(f, (long) (offset), whence)
+#  define ftello ftell
+#endif
+
+#define BLOCK_SIZE 0x4000
+/* 1 MB per disk */
+#define NUM_BLOCKS 64
+/* Number of blocks read ahead when a read misses the block following
+   the previous miss */
+#define READ_AHEAD 4
+
+typedef struct {
+	off_t pos; /* offset of the block in the file, -1 if unused */
+	int len; /* number of bytes of the file in the block */
+	int dirty;
+	unsigned int used; /* value of use_counter at the last access */
+	UBYTE data[BLOCK_SIZE];
+} block_t;
+
+struct DISKCACHE_t {
+	FILE *file;
+	off_t file_size;
+	off_t last_miss;
+	unsigned int use_counter;
+	int idle_frames; /* frames since the last write, -1 if nothing to write back */
+	DISKCACHE_t *next;
+	block_t blocks[NUM_BLOCKS];
+};
+
+/* All caches, for DISKCACHE_Frame */
+static DISKCACHE_t *caches = NULL;
+
+DISKCACHE_t *DISKCACHE_New(FILE *file)
+{
+	DISKCACHE_t *cache = (DISKCACHE_t *) Util_malloc(sizeof(DISKCACHE_t));
+	int i;
+	cache->file = file;
+	fseeko(file, 0, SEEK_END);
+	cache->file_size = ftello(file);
+	cache->last_miss = -1;
+	cache->use_counter = 0;
+	cache->idle_frames = -1;
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		cache->blocks[i].pos = -1;
+		cache->blocks[i].dirty = FALSE;
+		cache->blocks[i].used = 0;
+	}
+	cache->next = caches;
+	caches = cache;
+	return cache;
+}
+
+void DISKCACHE_Free(DISKCACHE_t *cache)
+{
+	DISKCACHE_t **p;
+	if (!DISKCACHE_Flush(cache))
+		Log_print("Error writing to disk image");
+	for (p = &caches; *p != NULL; p = &(*p)->next) {
+		if (*p == cache) {
+			*p = cache->next;
+			break;
+		}
+	}
+	free(cache);
+}
+
+static int WriteBlock(DISKCACHE_t *cache, block_t *block)
+{
+	if (fseeko(cache->file, block->pos, SEEK_SET) != 0
+	 || fwrite(block->data, 1, block->len, cache->file) != (size_t) block->len)
+		return FALSE;
+	block->dirty = FALSE;
+	return TRUE;
+}
+
+static block_t *FindBlock(DISKCACHE_t *cache, off_t pos)
+{
+	int i;
+	for (i = 0; i < NUM_BLOCKS; i++) {
+		if (cache->blocks[i].pos == pos)
+			return &cache->blocks[i];
+	}
+	return NULL;
+}
+
+/* Returns a free block, writing back the least recently used one if
+   needed, or NULL on error. */
+static block_t *EvictBlock(DISKCACHE_t *cache)
+{
+	block_t *victim = &cache->blocks[0];
+	int i;
+	for (i = 1; i < NUM_BLOCKS && victim->pos >= 0; i++) {
+		block_t *block = &cache->blocks[i];
+		if (block->pos < 0 || block->used < victim->used)
+			victim = block;
+	}
+	if (victim->dirty && !WriteBlock(cache, victim))
+		return NULL;
+	victim->pos = -1;
+	return victim;
+}
+
+/* Loads the block at POS into BLOCK. */
+static int LoadBlock(DISKCACHE_t *cache, block_t *block, off_t pos)
+{
+	size_t len = 0;
+	if (pos < cache->file_size) {
+		if (fseeko(cache->file, pos, SEEK_SET) != 0)
+			return FALSE;
+		len = fread(block->data, 1, BLOCK_SIZE, cache->file);
+		if (len < BLOCK_SIZE && ferror(cache->file)) {
+			clearerr(cache->file);
+			return FALSE;
+		}
+	}
+	memset(block->data + len, 0, BLOCK_SIZE - len);
+	block->pos = pos;
+	block->len = (int) len;
+	block->dirty = FALSE;
+	block->used = cache->use_counter;
+	return TRUE;
+}
+
+/* Returns the block at POS, loading it if LOAD is TRUE, or NULL on error. */
+static block_t *GetBlock(DISKCACHE_t *cache, off_t pos, int load)
+{
+	block_t *block = FindBlock(cache, pos);
+	cache->use_counter++;
+	if (block == NULL) {
+		int sequential = load && pos == cache->last_miss + BLOCK_SIZE;
+		if ((block = EvictBlock(cache)) == NULL)
+			return NULL;
+		if (load) {
+			if (!LoadBlock(cache, block, pos))
+				return NULL;
+		}
+		else {
+			block->pos = pos;
+			block->len = 0;
+			block->dirty = FALSE;
+			block->used = cache->use_counter;
+		}
+		cache->last_miss = pos;
+		if (sequential) {
+			/* Read the following blocks while the file is being read
+			   sequentially anyway. */
+			off_t next;
+			for (next = pos + BLOCK_SIZE; next < pos + READ_AHEAD * BLOCK_SIZE && next < cache->file_size; next += BLOCK_SIZE) {
+				block_t *ahead;
+				if (FindBlock(cache, next) != NULL)
+					continue;
+				cache->use_counter++;
+				if ((ahead = EvictBlock(cache)) == NULL || !LoadBlock(cache, ahead, next))
+					break;
+				cache->last_miss = next;
+			}
+		}
+	}
+	block->used = ++cache->use_counter;
+	return block;
+}
+
+int DISKCACHE_Read(DISKCACHE_t *cache, off_t offset, UBYTE *buf, int size)
+{
+	int done = 0;
+	if (offset >= cache->file_size)
+		return 0;
+	if (size > cache->file_size - offset)
+		size = (int) (cache->file_size - offset);
+	while (done < size) {
+		off_t pos = (offset + done) & ~(off_t) (BLOCK_SIZE - 1);
+		int start = (int) (offset + done - pos);
+		int len = BLOCK_SIZE - start;
+		block_t *block = GetBlock(cache, pos, TRUE);
+		if (block == NULL)
+			return -1;
+		if (len > size - done)
+			len = size - done;
+		memcpy(buf + done, block->data + start, len);
+		done += len;
+	}
+	return done;
+}
+
+int DISKCACHE_Write(DISKCACHE_t *cache, off_t offset, UBYTE const *buf, int size)
+{
+	int done = 0;
+	while (done < size) {
+		off_t pos = (offset + done) & ~(off_t) (BLOCK_SIZE - 1);
+		int start = (int) (offset + done - pos);
+		int len = BLOCK_SIZE - start;
+		block_t *block;
+		if (len > size - done)
+			len = size - done;
+		/* A block that is overwritten entirely needn't be read. */
+		if ((block = GetBlock(cache, pos, start != 0 || len != BLOCK_SIZE)) == NULL)
+			return FALSE;
+		memcpy(block->data + start, buf + done, len);
+		if (block->len < start + len)
+			block->len = start + len;
+		if (cache->file_size < pos + block->len)
+			cache->file_size = pos + block->len;
+		block->dirty = TRUE;
+		done += len;
+	}
+	cache->idle_frames = 0;
+	return TRUE;
+}
+
+int DISKCACHE_Flush(DISKCACHE_t *cache)
+{
+	/* Write the blocks in the order of the file. */
+	for (;;) {
+		block_t *first = NULL;
+		int i;
+		for (i = 0; i < NUM_BLOCKS; i++) {
+			block_t *block = &cache->blocks[i];
+			if (block->dirty && (first == NULL || block->pos < first->pos))
+				first = block;
+		}
+		if (first == NULL)
+			break;
+		if (!WriteBlock(cache, first))
+			return FALSE;
+	}
+	cache->idle_frames = -1;
+	return fflush(cache->file) == 0;
+}
+
+void DISKCACHE_Frame(void)
+{
+	DISKCACHE_t *cache;
+	for (cache = caches; cache != NULL; cache = cache->next) {
+		if (cache->idle_frames >= 0 && ++cache->idle_frames >= DISKCACHE_FLUSH_DELAY) {
+			if (!DISKCACHE_Flush(cache)) {
+				Log_print("Error writing to disk image");
+				/* Try again later. */
+				cache->idle_frames = 0;
+			}
+		}
+	}
+}
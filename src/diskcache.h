@@ -0,0 +1,42 @@
+#ifndef DISKCACHE_H_
+#define DISKCACHE_H_
+
+#include <stdio.h>
+#include <sys/types.h> /* off_t */
+
+#include "atari.h"
+
+/* A block cache for hard disk images (IDE and the SCSI disk of the MIO and
+   Black Box), so that sector accesses made from the emulated I/O registers
+   don't go to the host file one sector at a time.
+
+   Reads load whole blocks, and blocks following a sequential run are read
+   ahead. Writes only change the cached blocks; they are written back when
+   evicted, on DISKCACHE_Flush, and from DISKCACHE_Frame once the disk has
+   been idle for a while. */
+typedef struct DISKCACHE_t DISKCACHE_t;
+
+/* Creates a cache for FILE, which must be opened for reading and writing.
+   The file is not closed by the cache. */
+DISKCACHE_t *DISKCACHE_New(FILE *file);
+
+/* Writes back CACHE and frees it. */
+void DISKCACHE_Free(DISKCACHE_t *cache);
+
+/* Reads SIZE bytes at OFFSET into BUF. Returns the number of bytes read,
+   which is less than SIZE at the end of the file, or -1 on error. */
+int DISKCACHE_Read(DISKCACHE_t *cache, off_t offset, UBYTE *buf, int size);
+
+/* Writes SIZE bytes from BUF at OFFSET. Returns FALSE on error. */
+int DISKCACHE_Write(DISKCACHE_t *cache, off_t offset, UBYTE const *buf, int size);
+
+/* Writes all changed blocks to the file. Returns FALSE on error. */
+int DISKCACHE_Flush(DISKCACHE_t *cache);
+
+/* Called once per frame; writes back the caches that haven't been written
+   to for DISKCACHE_FLUSH_DELAY frames. */
+void DISKCACHE_Frame(void);
+
+#define DISKCACHE_FLUSH_DELAY 25
+
+#endif /* DISKCACHE_H_ */
@@ -249,6 +249,8 @@ static int ide_init_drive(struct ide_device *s, char *filename) {
     snprintf(s->drive_serial_str, sizeof(s->drive_serial_str),
             "QM%05d", s->drive_serial);
 
+    s->cache = DISKCACHE_New(s->file);
+
     ide_reset(s);
 
     return TRUE;
@@ -396,9 +398,8 @@ static void ide_sector_read(struct ide_device *s) {
         if (n > s->req_nb_sectors)
             n = s->req_nb_sectors;
 
-        if (fseeko(s->file, sector_num * SECTOR_SIZE, SEEK_SET) < 0)
-            goto fail;
-        if (fread(s->io_buffer, n * SECTOR_SIZE, 1, s->file) != 1)
+        if (DISKCACHE_Read(s->cache, sector_num * SECTOR_SIZE, s->io_buffer,
+                           n * SECTOR_SIZE) != n * SECTOR_SIZE)
             goto fail;
 
         if (IDE_debug) fprintf(stderr, "sector read OK\n");
@@ -428,15 +429,11 @@ static void ide_sector_write(struct ide_device *s) {
     if (n > s->req_nb_sectors)
         n = s->req_nb_sectors;
 
-    if (fseeko(s->file, sector_num * SECTOR_SIZE, SEEK_SET) < 0) {
-        fprintf(stderr, "FSEEKO FAILED\n");
+    if (!DISKCACHE_Write(s->cache, sector_num * SECTOR_SIZE, s->io_buffer,
+                         n * SECTOR_SIZE)) {
+        fprintf(stderr, "WRITE FAILED\n");
         goto fail;
     }
-    if (fwrite(s->io_buffer, n * SECTOR_SIZE, 1, s->file) != 1) {
-        fprintf(stderr, "FWRITE FAILED\n");
-        goto fail;
-    }
-    fflush(s->file);
 
     s->nsector -= n;
     if (s->nsector == 0) {
@@ -608,7 +605,8 @@ static void ide_command(struct ide_device *s, uint8_t val) {
 
     case WIN_FLUSH_CACHE:
     case WIN_FLUSH_CACHE_EXT:
-        fflush(s->file);
+        if (!DISKCACHE_Flush(s->cache))
+            goto abort_cmd;
         break;
 
     case WIN_STANDBY:
@@ -904,6 +902,7 @@ int IDE_Initialise(int *argc, char *argv[]) {
 void IDE_Exit(void)
 {
 	if (IDE_enabled) {
+		DISKCACHE_Free(device.cache);
 		fclose(device.file);
 		IDE_enabled = FALSE;
 	}
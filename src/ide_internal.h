@@ -7,6 +7,7 @@
 #ifdef HAVE_UNISTD_H
 #  include <unistd.h>
 #endif
+#include "diskcache.h"
 
 struct ide_device;
 
@@ -19,6 +20,7 @@ struct ide_device {
     int is_cdrom, is_cf;
 
     FILE *file;
+    DISKCACHE_t *cache;
     off_t filesize;
     int blocksize;
 
@@ -41,6 +41,10 @@ enum { DEFAULT_BUFFER_SIZE = 132 };
 /* Baudrate for all written blocks and for reading from raw files. */
 enum { DEFAULT_BAUDRATE = 600 };
 
+/* Duration of an accelerated byte, in CPU ticks: 10 scanlines, enough
+   for the OS to handle each SERIN interrupt. */
+enum { ACCEL_BYTE_TICKS = 10 * 114 };
+
 struct IMG_TAPE_t {
 	FILE *file; /* Stream for reading/writing of the tape image */
 	int isCAS; /* Indicates if the file is in CAS format, or a raw binary file */
@@ -51,6 +55,8 @@ struct IMG_TAPE_t {
 	int next_blockbyte; /* Index of the byte in this block that will be read next (counted from 0) */
 	unsigned int current_block; /* Number of the currently-read/written block (counted from 0) */
 	int block_is_fsk; /* FALSE - current chunk's type  is "data", otherwise "fsk " */
+	int block_is_standard; /* Indicates if the current block is a standard record, see IMG_TAPE_StandardRecord() */
+	unsigned int byte_ticks; /* Duration of the byte being read, in CPU ticks */
 	int block_length; /* Length of the block currently held in BUFFER */
 	int num_blocks; /* Number of data blocks in the whole file */
 	ULONG block_offsets[MAX_BLOCKS]; /* File offsets for each data block*/
@@ -237,6 +243,7 @@ IMG_TAPE_t *IMG_TAPE_Open(char const *filename, int *writable, char const **desc
 	img->save_gap = 0;
 	img->next_blockbyte = 0;
 	img->block_length = 0;
+	img->byte_ticks = 10 * 1789790 / DEFAULT_BAUDRATE;
 	img->current_block = 0;
 	img->buffer = (UBYTE *)Util_malloc((img->buffer_size = DEFAULT_BUFFER_SIZE) * sizeof(UBYTE));
 	img->was_writing = FALSE;
@@ -297,6 +304,7 @@ IMG_TAPE_t *IMG_TAPE_Create(char const *filename, char const *description)
 	img->save_gap = 0;
 	img->next_blockbyte = 0;
 	img->block_length = 0;
+	img->byte_ticks = 10 * 1789790 / DEFAULT_BAUDRATE;
 	img->current_block = 0;
 	img->num_blocks = 0;
 	img->block_offsets[0] = strlen(description) + 16;
@@ -353,6 +361,9 @@ static int ReadNextRecord(IMG_TAPE_t *file, int *gap)
 		EnlargeBuffer(file, length);
 		if (fread(file->buffer, 1, length, file->file) < length)
 			return FALSE;
+		file->block_is_standard = !file->block_is_fsk && length >= 4 &&
+		                          file->buffer[0] == 0x55 && file->buffer[1] == 0x55 &&
+		                          file->buffer[length - 1] == SIO_ChkSum(file->buffer, length - 1);
 	}
 	else {
 		file->block_is_fsk = FALSE;
@@ -380,12 +391,13 @@ static int ReadNextRecord(IMG_TAPE_t *file, int *gap)
 				file->buffer[2] = 0xfc;	/* full record */
 		}
 		file->buffer[0x83] = SIO_ChkSum(file->buffer, 0x83);
+		file->block_is_standard = TRUE;
 	}
 	file->block_length = length;
 	return TRUE;
 }
 
-int IMG_TAPE_Read(IMG_TAPE_t *file, unsigned int *duration, int *is_gap, UBYTE *byte)
+int IMG_TAPE_Read(IMG_TAPE_t *file, unsigned int *duration, int *is_gap, UBYTE *byte, int accel)
 {
 	if (file->was_writing) {
 		CassetteFlush(file);
@@ -417,8 +429,14 @@ int IMG_TAPE_Read(IMG_TAPE_t *file, unsigned int *duration, int *is_gap, UBYTE *
 	} else {
 		*byte = file->buffer[file->next_blockbyte++];
 		*is_gap = FALSE;
-		/* Next event will be after 10 bits of data gets loaded. */
-		*duration = 10 * 1789790 / (file->isCAS ? file->block_baudrates[file->current_block] : 600);
+		/* Next event will be after 10 bits of data gets loaded. The OS
+		   measures the baudrate on the two sync bytes, so they are never
+		   accelerated. */
+		if (accel && file->block_is_standard && file->next_blockbyte > 2)
+			file->byte_ticks = ACCEL_BYTE_TICKS;
+		else
+			file->byte_ticks = 10 * 1789790 / (file->isCAS ? file->block_baudrates[file->current_block] : 600);
+		*duration = file->byte_ticks;
 	}
 	return TRUE;
 }
@@ -509,9 +527,8 @@ int IMG_TAPE_SerinStatus(IMG_TAPE_t *file, int event_time_left)
 		int bit = 0; /* 0: stop bit, 1: 7th bit, ..., 8: 0th bit, 9: start bit */
 
 		/* exam rate; if time_to_irq < duration of one byte */
-		if (event_time_left <
-			10 * 1789790 / (file->isCAS ? file->block_baudrates[file->current_block] : 600) - 1) {
-			bit = event_time_left / (1789790 / (file->isCAS ? file->block_baudrates[file->current_block] : 600));
+		if (event_time_left < (int)file->byte_ticks - 1) {
+			bit = event_time_left / (int)(file->byte_ticks / 10);
 		}
 		else {
 			bit = 0;
@@ -530,6 +547,11 @@ int IMG_TAPE_SerinStatus(IMG_TAPE_t *file, int event_time_left)
 	}
 }
 
+int IMG_TAPE_StandardRecord(IMG_TAPE_t *file)
+{
+	return !file->was_writing && file->block_length != 0 && file->block_is_standard;
+}
+
 int IMG_TAPE_SkipToData(IMG_TAPE_t *file, int ms)
 {
 	if (file->was_writing) {
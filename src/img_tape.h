@@ -50,8 +50,16 @@ IMG_TAPE_t *IMG_TAPE_Create(char const *filename, char const *description);
    Stores a boolean in *IS_GAP, indicating if the event is an IRG (TRUE)
    or a byte (FALSE).
    If *IS_GAP == FALSE, stores the byte being read in *BYTE.
+   If ACCEL is TRUE, the bytes of standard records following the two sync
+   bytes last only 10 scanlines each.
    Returns TRUE on success or FALSE on read error or EOF. */
-int IMG_TAPE_Read(IMG_TAPE_t *file, unsigned int *duration, int *is_gap, UBYTE *byte);
+int IMG_TAPE_Read(IMG_TAPE_t *file, unsigned int *duration, int *is_gap, UBYTE *byte, int accel);
+
+/* Returns TRUE if the block being read (or the block the current gap
+   precedes) is a standard record: a data block that starts with two 0x55
+   sync bytes and ends with a correct checksum. FSK blocks and records of
+   non-standard formats are not standard. */
+int IMG_TAPE_StandardRecord(IMG_TAPE_t *file);
 
 /* Advances the tape file by a given DURATION (in CPU ticks) during
    writing. */
@@ -277,6 +277,53 @@ int libatari800_reboot_with_file(const char *filename)
 }
 
 
+/** Run until loading has finished
+ *
+ * Emulates frames as fast as possible, without drawing the screen and
+ * without generating sound, until no disk sector, cassette block or
+ * executable file has been read for \a idle_frames frames. Use it after
+ * \a libatari800_reboot_with_file or \a libatari800_mount_disk_image to
+ * skip the boot and load phases of automated runs. The emulated machine
+ * runs exactly as it would otherwise; only its output is not produced.
+ *
+ * If \a max_frames frames have run before loading stops, the screen stays
+ * blank until loading has finished during later calls to
+ * \a libatari800_next_frame.
+ *
+ * @param input keyboard and joystick state held during the loading, may be
+ * NULL
+ * @param idle_frames number of frames without loading that end the run
+ * @param max_frames maximum number of frames to run
+ *
+ * @returns number of frames emulated, or -1 if the emulation stopped with an
+ * error other than a display list error (see \a libatari800_error_message)
+ */
+int libatari800_turbo_until_idle(input_template_t *input, int idle_frames, int max_frames)
+{
+	input_template_t none;
+	int lazy = LIBATARI800_Sound_GetLazy();
+	int frames = 0;
+
+	if (input == NULL) {
+		libatari800_clear_input_array(&none);
+		input = &none;
+	}
+	Atari800_fast_boot_idle = idle_frames;
+	Atari800_StartFastBoot();
+	LIBATARI800_Sound_SetLazy(TRUE);
+	while (frames < max_frames && Atari800_FastBootFrame()) {
+		/* there is no display list while the OS is booting */
+		if (!libatari800_next_frame(input) && libatari800_error_code != LIBATARI800_DLIST_ERROR) {
+			frames = -1;
+			break;
+		}
+		frames++;
+	}
+	LIBATARI800_Sound_SetLazy(lazy);
+	return frames;
+}
+
+
 /** Return pointer to main memory
  *
  * This is actual array containing the emulator's main bank of 64k of RAM.
@@ -318,6 +365,38 @@ UBYTE *libatari800_get_screen_ptr()
 }
 
 
+/** Set a render target for the emulated screen
+ *
+ * After each call to \a libatari800_next_frame, the selected part of the
+ * emulated screen is written into \a buffer in the requested pixel format,
+ * so the caller does not need to crop or convert the 384x240 array returned
+ * by \a libatari800_get_screen_ptr. The buffer must remain valid until the
+ * render target is changed or disabled.
+ *
+ * The RGB formats use the current emulator palette. \a LIBATARI800_VIDEO_XRGB32
+ * pixels are 32-bit native-endian 0x00RRGGBB values, \a LIBATARI800_VIDEO_RGB24
+ * pixels are R, G, B byte triplets and \a LIBATARI800_VIDEO_RGB565 pixels are
+ * 16-bit native-endian values.
+ *
+ * @param buffer destination buffer, or NULL to disable the render target
+ * @param format one of the LIBATARI800_VIDEO_* pixel format constants
+ * @param left first column of the emulated screen to output (0 - 383)
+ * @param top first scan line of the emulated screen to output (0 - 239)
+ * @param width number of columns to output
+ * @param height number of scan lines to output
+ * @param pitch distance in bytes between lines in \a buffer, or 0 if the
+ * lines are tightly packed
+ *
+ * @retval FALSE if the format is unknown, the area lies outside the emulated
+ * screen or the pitch is too small
+ * @retval TRUE if successful
+ */
+int libatari800_set_video_output(void *buffer, int format, int left, int top, int width, int height, int pitch)
+{
+	return LIBATARI800_Video_SetOutput(buffer, format, left, top, width, height, pitch);
+}
+
+
 /** Return pointer to sound data
  *
  * If sound is used, each emulated frame will fill the sound buffer with samples
@@ -336,6 +415,7 @@ UBYTE *libatari800_get_screen_ptr()
  */
 UBYTE *libatari800_get_sound_buffer()
 {
+	LIBATARI800_Sound_Render();
 	return (UBYTE *)LIBATARI800_Sound_array;
 }
 
@@ -345,17 +425,91 @@ UBYTE *libatari800_get_sound_buffer()
  * @returns number of bytes of valid data in the sound buffer
  */
 int libatari800_get_sound_buffer_len() {
+	LIBATARI800_Sound_Render();
 	return (int)sound_array_fill;
 }
 
 
+/** Generate sound only when it is requested
+ *
+ * Programs that ignore the sound, like headless training or benchmarking
+ * runs, can enable lazy sound to skip audio synthesis. Writes to the POKEY
+ * sound registers are then recorded during each frame, and the samples of
+ * the last frame are only generated when \a libatari800_get_sound_buffer or
+ * \a libatari800_get_sound_buffer_len is called. Frames whose sound is not
+ * requested before the next call to \a libatari800_next_frame are never
+ * synthesised; their register writes still reach the sound engine, so
+ * later frames sound right, but the waveforms are not continuous across the
+ * skipped frames.
+ *
+ * When the sound of every frame is requested, the output is the same as
+ * without lazy sound. Sound is always generated for every frame while a
+ * recording is being made.
+ *
+ * @param lazy TRUE to enable lazy sound, FALSE to generate sound for every
+ * frame (the default)
+ */
+void libatari800_set_lazy_sound(int lazy)
+{
+	LIBATARI800_Sound_SetLazy(lazy);
+}
+
+
+/** Collect the sound of several frames in the sound buffer
+ *
+ * By default the sound buffer holds the samples of the last emulated frame.
+ * When \a frames is greater than 1, the samples of \a frames consecutive
+ * frames are appended to the buffer before it is started again, so a
+ * program that encodes or outputs audio in larger blocks can read it once
+ * every \a frames calls to \a libatari800_next_frame. The buffer is complete
+ * when the \a frames member returned by \a libatari800_get_sound_timestamp
+ * is equal to \a frames.
+ *
+ * Lazy sound is turned off while more than one frame is collected. Any
+ * samples in the buffer are discarded when the setting is changed.
+ *
+ * @param frames number of frames in the sound buffer, 1 by default
+ */
+void libatari800_set_sound_batch(int frames)
+{
+	LIBATARI800_Sound_SetBatch(frames);
+}
+
+
+/** Return the position of the sound buffer in the audio stream
+ *
+ * The number of samples in each frame is computed from the exact frame
+ * rate of the emulated machine, so the samples never drift from the
+ * emulated time. The timestamp gives the position of the first sample in
+ * the buffer returned by \a libatari800_get_sound_buffer, counted from the
+ * start of the emulation (or from the last change of the sound settings)
+ * as:
+ *
+ * - \a sample: the number of samples (per channel) before it
+ * - \a tick: the number of CPU cycles (POKEY 1.79MHz clock ticks) before
+ *   the start of the frame it belongs to; 114 per scan line
+ * - \a frames: the number of frames whose sound is in the buffer
+ *
+ * The values are saved with \a libatari800_get_current_state.
+ *
+ * @param timestamp pointer to an already allocated \a sound_timestamp_t
+ * structure
+ */
+void libatari800_get_sound_timestamp(sound_timestamp_t *timestamp)
+{
+	timestamp->sample = LIBATARI800_Sound_sample;
+	timestamp->tick = LIBATARI800_Sound_tick;
+	timestamp->frames = LIBATARI800_Sound_frames;
+}
+
+
 /** Return the maximum size of the sound buffer.
  *
  * @returns number of bytes allocated in sound buffer
  */
 
 int libatari800_get_sound_buffer_allocated_size() {
-	return (int)sound_hw_buffer_size;
+	return (int)sound_hw_buffer_size * LIBATARI800_Sound_GetBatch();
 }
 
 
@@ -455,7 +609,8 @@ void libatari800_get_current_state(emulator_state_t *state)
 	LIBATARI800_StateSave(state->state, &state->tags);
 	state->flags.selftest_enabled = MEMORY_selftest_enabled;
 	state->flags.nframes = (ULONG)Atari800_nframes;
-	state->flags.sample_residual = (ULONG)(0xffffffff * sample_residual);
+	state->flags.sample_residual = LIBATARI800_Sound_GetResidual();
+	LIBATARI800_Sound_GetPosition(&state->flags.sound_sample, &state->flags.sound_tick);
 }
 
 
@@ -475,7 +630,7 @@ void libatari800_restore_state(emulator_state_t *state)
 	LIBATARI800_StateLoad(state->state);
 	MEMORY_selftest_enabled = state->flags.selftest_enabled;
 	Atari800_nframes = state->flags.nframes;
-	sample_residual = (double)state->flags.sample_residual / (double)0xffffffff;
+	LIBATARI800_Sound_SetTiming(state->flags.sample_residual, state->flags.sound_sample, state->flags.sound_tick);
 }
 
 
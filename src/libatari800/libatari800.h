@@ -1,6 +1,8 @@
 #ifndef LIBATARI800_H_
 #define LIBATARI800_H_
 
+#include <stdint.h>
+
 #ifndef UBYTE
 #define UBYTE unsigned char
 #endif
@@ -10,7 +12,6 @@
 #endif
 
 #ifndef ULONG
-#include <stdint.h>
 #define ULONG uint32_t
 #endif
 
@@ -142,8 +143,18 @@ typedef struct {
     UBYTE _align1[3];
     ULONG nframes;
     ULONG sample_residual;
+    ULONG _align2;
+    uint64_t sound_sample;
+    uint64_t sound_tick;
 } statesav_flags_t;
 
+/* Position of the sound buffer returned by libatari800_get_sound_timestamp */
+typedef struct {
+    uint64_t sample;
+    uint64_t tick;
+    int frames;
+} sound_timestamp_t;
+
 typedef struct {
     union {
         statesav_tags_t tags;
@@ -266,6 +277,17 @@ extern int libatari800_error_code;
 #define LIBATARI800_MEMO_PAD 6
 #define LIBATARI800_INVALID_ESCAPE_OPCODE 7
 
+/* Pixel formats for libatari800_set_video_output */
+#define LIBATARI800_VIDEO_INDEXED8 0
+#define LIBATARI800_VIDEO_RGB565 1
+#define LIBATARI800_VIDEO_RGB24 2
+#define LIBATARI800_VIDEO_XRGB32 3
+
+/* Horizontal crop of the 384x240 screen that leaves the 336 pixels wide
+   area shown by most front ends */
+#define LIBATARI800_VIDEO_DEFAULT_LEFT 24
+#define LIBATARI800_VIDEO_DEFAULT_WIDTH 336
+
 int libatari800_init(int argc, char **argv);
 
 const char *libatari800_error_message();
@@ -280,14 +302,24 @@ int libatari800_mount_disk_image(int diskno, const char *filename, int readonly)
 
 int libatari800_reboot_with_file(const char *filename);
 
+int libatari800_turbo_until_idle(input_template_t *input, int idle_frames, int max_frames);
+
 UBYTE *libatari800_get_main_memory_ptr();
 
 UBYTE *libatari800_get_screen_ptr();
 
+int libatari800_set_video_output(void *buffer, int format, int left, int top, int width, int height, int pitch);
+
 UBYTE *libatari800_get_sound_buffer();
 
 int libatari800_get_sound_buffer_len();
 
+void libatari800_set_lazy_sound(int lazy);
+
+void libatari800_set_sound_batch(int frames);
+
+void libatari800_get_sound_timestamp(sound_timestamp_t *timestamp);
+
 int libatari800_get_sound_buffer_allocated_size();
 
 int libatari800_get_sound_frequency();
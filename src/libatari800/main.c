@@ -55,6 +55,9 @@
 /* mainloop includes */
 #include "antic.h"
 #include "devices.h"
+#if defined(IDE) || defined(PBI_MIO) || defined(PBI_BB)
+#include "diskcache.h"
+#endif
 #include "gtia.h"
 #include "pokey.h"
 #ifdef PBI_BB
@@ -125,15 +128,23 @@ void LIBATARI800_Frame(void)
 	VOTRAXSND_Frame(); /* for the Votrax */
 #endif
 	Devices_Frame();
+#if defined(IDE) || defined(PBI_MIO) || defined(PBI_BB)
+	DISKCACHE_Frame();
+#endif
 	INPUT_Frame();
 	GTIA_Frame();
-	ANTIC_Frame(TRUE);
-	INPUT_DrawMousePointer();
-	Screen_DrawAtariSpeed(Util_time());
-	Screen_DrawDiskLED();
-	Screen_Draw1200LED();
+	/* the screen is not drawn while booting fast */
+	if (Atari800_FastBootFrame())
+		ANTIC_Frame(Atari800_collisions_in_skipped_frames);
+	else {
+		ANTIC_Frame(TRUE);
+		INPUT_DrawMousePointer();
+		Screen_DrawAtariSpeed(Util_time());
+		Screen_DrawDiskLED();
+		Screen_Draw1200LED();
+	}
 	POKEY_Frame();
-	Sound_Update();
+	LIBATARI800_Sound_Update();
 	Atari800_nframes++;
 }
 
@@ -26,13 +26,18 @@
 #include "config.h"
 #include <stdlib.h>
 #include <string.h>
-#include <math.h>
+#include <stdint.h>
 
 #include "atari.h"
+#include "antic.h"
+#include "file_export.h"
+#include "gtia.h"
 #include "log.h"
 #include "platform.h"
+#include "pokeysnd.h"
 #include "init.h"
 #include "sound.h"
+#include "../sound.h"
 #include "util.h"
 
 UBYTE *LIBATARI800_Sound_array;
@@ -41,30 +46,361 @@ unsigned int sound_array_fill = 0;
 
 unsigned int sound_hw_buffer_size = 0;
 
-/* difference between an integer sample rate and the floating point sample rate, used
-   keep track of which frames need to drop a sample to stay at the constant audio
-   sampling rate */
-static double sample_diff;
+/* Sound timing. A frame lasts exactly Atari800_tv_mode * 228 / CLOCK2
+   seconds, where CLOCK2 is twice the CPU clock, so the number of samples in
+   each frame is computed in integers and the sound never drifts from the
+   emulated time. sample_rest is the fraction of a sample carried over to
+   the next frame, in 1/CLOCK2 units. */
+#define CLOCK2_PAL 3546895
+#define CLOCK2_NTSC 3579545
 
-double sample_residual;
+static ULONG sample_rest = 0;
+static unsigned int buffer_frames;
+
+/* Samples and CPU cycles produced since the sound was set up. */
+static uint64_t sample_count = 0;
+static uint64_t tick_count = 0;
+
+uint64_t LIBATARI800_Sound_sample = 0;
+uint64_t LIBATARI800_Sound_tick = 0;
+int LIBATARI800_Sound_frames = 0;
+
+/* Number of frames collected in LIBATARI800_Sound_array before it is
+   started again. */
+static int sound_batch = 1;
+
+/* Lazy sound. While enabled, the sound engine's update functions are
+   replaced by Log* functions that append the calls, with the CPU clock and
+   the state of the console speaker, to sound_log. At the end of a frame the
+   logged entries become the pending frame, which is only synthesised when
+   its samples are requested. If the next frame ends first, the pending
+   frame's entries are passed to the engine without generating samples. */
+enum {
+	LOG_UPDATE,
+	LOG_SERIO,
+	LOG_CONSOL,
+	LOG_VOL_ONLY
+};
+
+typedef struct {
+	UBYTE type;
+	UBYTE val;
+	UBYTE chip;
+	UBYTE gain;
+	UWORD addr;
+	int speaker;
+	unsigned int clock;
+} sound_log_t;
+
+static int lazy_sound = FALSE;
+static sound_log_t *sound_log = NULL;
+static int sound_log_len = 0;
+static int sound_log_size = 0;
+
+/* Number of sound_log entries that belong to the pending frame, or -1 if
+   there is no pending frame. */
+static int pending_len = -1;
+/* Size in bytes and end clock of the pending frame. */
+static unsigned int pending_size;
+static unsigned int pending_clock;
+
+/* The sound engine's functions, called when the log is replayed. */
+static void (*engine_update)(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain);
+#ifdef SERIO_SOUND
+static void (*engine_serio)(int out, UBYTE data);
+#endif
+#ifdef CONSOLE_SOUND
+static void (*engine_consol)(int set);
+#endif
+#ifdef VOL_ONLY_SOUND
+static void (*engine_vol_only)(void);
+#endif
+
+static sound_log_t *NewLogEntry(UBYTE type)
+{
+	sound_log_t *entry;
+	if (sound_log_len >= sound_log_size) {
+		sound_log_size = sound_log_size == 0 ? 1024 : 2 * sound_log_size;
+		sound_log = (sound_log_t *) Util_realloc(sound_log, sound_log_size * sizeof(sound_log_t));
+	}
+	entry = sound_log + sound_log_len++;
+	entry->type = type;
+	entry->clock = ANTIC_CPU_CLOCK;
+	entry->speaker = GTIA_speaker;
+	return entry;
+}
+
+static void LogUpdate(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain)
+{
+	sound_log_t *entry = NewLogEntry(LOG_UPDATE);
+	entry->addr = addr;
+	entry->val = val;
+	entry->chip = chip;
+	entry->gain = gain;
+}
+
+#ifdef SERIO_SOUND
+static void LogSerio(int out, UBYTE data)
+{
+	sound_log_t *entry = NewLogEntry(LOG_SERIO);
+	entry->chip = (UBYTE) out;
+	entry->val = data;
+}
+#endif
+
+#ifdef CONSOLE_SOUND
+static void LogConsol(int set)
+{
+	NewLogEntry(LOG_CONSOL)->val = (UBYTE) set;
+}
+#endif
+
+#ifdef VOL_ONLY_SOUND
+static void LogVolOnly(void)
+{
+	NewLogEntry(LOG_VOL_ONLY);
+}
+#endif
+
+/* Routes the sound engine's update functions through the log. Called every
+   frame, because POKEYSND_Init() restores the engine's functions. */
+static void InstallLog(void)
+{
+	if (POKEYSND_Update_ptr != LogUpdate) {
+		engine_update = POKEYSND_Update_ptr;
+		POKEYSND_Update_ptr = LogUpdate;
+	}
+#ifdef SERIO_SOUND
+	if (POKEYSND_UpdateSerio != LogSerio) {
+		engine_serio = POKEYSND_UpdateSerio;
+		POKEYSND_UpdateSerio = LogSerio;
+	}
+#endif
+#ifdef CONSOLE_SOUND
+	if (POKEYSND_UpdateConsol_ptr != LogConsol) {
+		engine_consol = POKEYSND_UpdateConsol_ptr;
+		POKEYSND_UpdateConsol_ptr = LogConsol;
+	}
+#endif
+#ifdef VOL_ONLY_SOUND
+	if (POKEYSND_UpdateVolOnly != LogVolOnly) {
+		engine_vol_only = POKEYSND_UpdateVolOnly;
+		POKEYSND_UpdateVolOnly = LogVolOnly;
+	}
+#endif
+}
+
+static void RemoveLog(void)
+{
+	if (POKEYSND_Update_ptr == LogUpdate)
+		POKEYSND_Update_ptr = engine_update;
+#ifdef SERIO_SOUND
+	if (POKEYSND_UpdateSerio == LogSerio)
+		POKEYSND_UpdateSerio = engine_serio;
+#endif
+#ifdef CONSOLE_SOUND
+	if (POKEYSND_UpdateConsol_ptr == LogConsol)
+		POKEYSND_UpdateConsol_ptr = engine_consol;
+#endif
+#ifdef VOL_ONLY_SOUND
+	if (POKEYSND_UpdateVolOnly == LogVolOnly)
+		POKEYSND_UpdateVolOnly = engine_vol_only;
+#endif
+}
+
+/* Makes ANTIC_CPU_CLOCK return CLOCK, for the engine functions that
+   timestamp volume-only samples. */
+static void SetCpuClock(unsigned int clock)
+{
+	ANTIC_screenline_cpu_clock = clock - ANTIC_XPOS;
+}
+
+/* Passes the first LEN entries of the log to the sound engine and removes
+   them from the log. */
+static void ReplayLog(int len)
+{
+	unsigned int saved_clock = ANTIC_screenline_cpu_clock;
+	int saved_speaker = GTIA_speaker;
+	/* the engine's functions may call each other through the pointers */
+	int installed = POKEYSND_Update_ptr == LogUpdate;
+	int i;
+
+	if (installed)
+		RemoveLog();
+	for (i = 0; i < len; i++) {
+		sound_log_t const *entry = sound_log + i;
+		SetCpuClock(entry->clock);
+		GTIA_speaker = entry->speaker;
+		switch (entry->type) {
+		case LOG_UPDATE:
+			engine_update(entry->addr, entry->val, entry->chip, entry->gain);
+			break;
+#ifdef SERIO_SOUND
+		case LOG_SERIO:
+			engine_serio(entry->chip, entry->val);
+			break;
+#endif
+#ifdef CONSOLE_SOUND
+		case LOG_CONSOL:
+			engine_consol(entry->val);
+			break;
+#endif
+#ifdef VOL_ONLY_SOUND
+		case LOG_VOL_ONLY:
+			engine_vol_only();
+			break;
+#endif
+		default:
+			break;
+		}
+	}
+	ANTIC_screenline_cpu_clock = saved_clock;
+	GTIA_speaker = saved_speaker;
+	if (installed)
+		InstallLog();
+
+	sound_log_len -= len;
+	memmove(sound_log, sound_log + len, sound_log_len * sizeof(sound_log_t));
+	if (pending_len >= 0)
+		pending_len -= len;
+}
+
+/* Drops the samples of the pending frame, keeping its effect on the sound
+   engine's registers. */
+static void SkipPendingFrame(void)
+{
+	unsigned int saved_clock = ANTIC_screenline_cpu_clock;
+	ReplayLog(pending_len);
+#ifdef VOL_ONLY_SOUND
+	SetCpuClock(pending_clock);
+	POKEYSND_DiscardVolOnly();
+	ANTIC_screenline_cpu_clock = saved_clock;
+#endif
+	pending_len = -1;
+}
+
+void LIBATARI800_Sound_Render(void)
+{
+	unsigned int saved_clock;
+	if (pending_len < 0)
+		return;
+	ReplayLog(pending_len);
+	saved_clock = ANTIC_screenline_cpu_clock;
+	SetCpuClock(pending_clock);
+	POKEYSND_Process(LIBATARI800_Sound_array, pending_size / Sound_out.sample_size);
+	ANTIC_screenline_cpu_clock = saved_clock;
+	sound_array_fill = pending_size;
+	pending_len = -1;
+}
+
+void LIBATARI800_Sound_SetLazy(int lazy)
+{
+	if (!lazy && lazy_sound) {
+		LIBATARI800_Sound_Render();
+		ReplayLog(sound_log_len);
+		RemoveLog();
+	}
+	lazy_sound = lazy;
+}
+
+int LIBATARI800_Sound_GetLazy(void)
+{
+	return lazy_sound;
+}
+
+void LIBATARI800_Sound_Update(void)
+{
+	if (!lazy_sound || !Sound_enabled || File_Export_IsRecording() || sound_batch > 1) {
+		if (lazy_sound) {
+			/* generate this frame immediately */
+			LIBATARI800_Sound_Render();
+			ReplayLog(sound_log_len);
+		}
+		Sound_Update();
+		return;
+	}
+	if (pending_len >= 0)
+		SkipPendingFrame();
+	InstallLog();
+	pending_len = sound_log_len;
+	pending_size = PLATFORM_SoundAvailable();
+	pending_clock = ANTIC_CPU_CLOCK;
+}
+
+static ULONG Clock2(void)
+{
+	return Atari800_tv_mode == Atari800_TV_PAL ? CLOCK2_PAL : CLOCK2_NTSC;
+}
+
+/* Returns the number of samples in the next frame. */
+static unsigned int FrameSamples(void)
+{
+	ULONG clock2 = Clock2();
+	uint64_t rest = sample_rest + (uint64_t) Sound_out.freq * Atari800_tv_mode * 2 * ANTIC_LINE_C;
+	sample_rest = (ULONG) (rest % clock2);
+	return (unsigned int) (rest / clock2);
+}
+
+void LIBATARI800_Sound_SetBatch(int frames)
+{
+	if (frames < 1)
+		frames = 1;
+	if (frames > 1)
+		LIBATARI800_Sound_SetLazy(FALSE);
+	sound_batch = frames;
+	if (LIBATARI800_Sound_array != NULL)
+		LIBATARI800_Sound_array = Util_realloc(LIBATARI800_Sound_array, sound_hw_buffer_size * sound_batch);
+	/* the next frame starts a new buffer */
+	sound_array_fill = 0;
+	LIBATARI800_Sound_frames = 0;
+}
+
+int LIBATARI800_Sound_GetBatch(void)
+{
+	return sound_batch;
+}
+
+ULONG LIBATARI800_Sound_GetResidual(void)
+{
+	return (ULONG) ((uint64_t) sample_rest * 0xffffffff / Clock2());
+}
+
+void LIBATARI800_Sound_GetPosition(uint64_t *sample, uint64_t *tick)
+{
+	*sample = sample_count;
+	*tick = tick_count;
+}
+
+void LIBATARI800_Sound_SetTiming(ULONG residual, uint64_t sample, uint64_t tick)
+{
+	ULONG clock2 = Clock2();
+	sample_rest = (ULONG) ((uint64_t) residual * clock2 / 0xffffffff);
+	if (sample_rest >= clock2)
+		sample_rest = clock2 - 1;
+	sample_count = LIBATARI800_Sound_sample = sample;
+	tick_count = LIBATARI800_Sound_tick = tick;
+	sound_array_fill = 0;
+	LIBATARI800_Sound_frames = 0;
+}
 
 int PLATFORM_SoundSetup(Sound_setup_t *setup)
 {
-	double refresh_rate;
-	double samples_per_video_frame;
+	ULONG clock2 = Clock2();
 
-	refresh_rate = Atari800_tv_mode == Atari800_TV_PAL ? Atari800_FPS_PAL : Atari800_FPS_NTSC;
-	samples_per_video_frame = setup->freq / refresh_rate;
-	setup->buffer_frames = (int)(ceil(samples_per_video_frame));
+	setup->buffer_frames = (int) (((uint64_t) setup->freq * Atari800_tv_mode * 2 * ANTIC_LINE_C + clock2 - 1) / clock2);
+	buffer_frames = setup->buffer_frames;
 
 	sound_hw_buffer_size = setup->buffer_frames * setup->sample_size * setup->channels;
 	if (sound_hw_buffer_size == 0)
 	        return FALSE;
 
-	LIBATARI800_Sound_array = Util_malloc(sound_hw_buffer_size);
+	LIBATARI800_Sound_array = Util_malloc(sound_hw_buffer_size * sound_batch);
 
-	sample_diff = (double)setup->buffer_frames - samples_per_video_frame;
-	sample_residual = 0;
+	sample_rest = 0;
+	sample_count = tick_count = 0;
+	LIBATARI800_Sound_sample = LIBATARI800_Sound_tick = 0;
+	LIBATARI800_Sound_frames = 0;
+	sound_array_fill = 0;
 
 	return TRUE;
 }
@@ -72,6 +408,11 @@ int PLATFORM_SoundSetup(Sound_setup_t *setup)
 void PLATFORM_SoundExit(void)
 {
 	free(LIBATARI800_Sound_array);
+	LIBATARI800_Sound_array = NULL;
+	free(sound_log);
+	sound_log = NULL;
+	sound_log_len = sound_log_size = 0;
+	pending_len = -1;
 }
 
 void PLATFORM_SoundPause(void)
@@ -85,27 +426,31 @@ void PLATFORM_SoundContinue(void)
 /* Called just before audio buffer is filled; used to initialize sound parameters */
 unsigned int PLATFORM_SoundAvailable(void)
 {
-	int buf_size = sound_hw_buffer_size;
-
-	/* Because the frame rate is not an integer (59.92 NTSC, 49.86 PAL), the sample
-	   rate will not be constant. For example, on NTSC with a sample rate of 44100Hz,
-	   there should be 735.9476... samples per second. But, obviously there can't be
-	   a fraction of a sample, so sample sizes will mostly be 736 samples with the
-	   occasional 735 thrown in to make the rate average to 44100Hz. The sample_residual
-	   keeps track of the fractional samples to see when we must shorten the sample
-	   buffer. */
-	sample_residual += sample_diff;
-	if (sample_residual > 1.0) {
-		sample_residual -= 1.0;
-		buf_size -= Sound_out.sample_size * Sound_out.channels;
+	/* Because the frame rate is not an integer (59.92 NTSC, 49.86 PAL), the
+	   number of samples is not the same in all frames. For example, on NTSC
+	   with a sample rate of 44100Hz there are 735.9476... samples per frame,
+	   so most frames have 736 samples with the occasional 735 thrown in. */
+	unsigned int samples = FrameSamples();
+	/* only if the TV mode was changed without setting up the sound again */
+	if (samples > buffer_frames)
+		samples = buffer_frames;
+
+	if (LIBATARI800_Sound_frames == 0 || LIBATARI800_Sound_frames >= sound_batch) {
+		/* start a new buffer */
+		sound_array_fill = 0;
+		LIBATARI800_Sound_sample = sample_count;
+		LIBATARI800_Sound_tick = tick_count;
+		LIBATARI800_Sound_frames = 0;
 	}
+	LIBATARI800_Sound_frames++;
+	sample_count += samples;
+	tick_count += Atari800_tv_mode * ANTIC_LINE_C;
 
-	sound_array_fill = 0;
-	return buf_size;
+	return samples * Sound_out.sample_size * Sound_out.channels;
 }
 
 void PLATFORM_SoundWrite(UBYTE const *buffer, unsigned int size)
 {
-	memcpy(LIBATARI800_Sound_array, buffer, size);
-	sound_array_fill = size;
+	memcpy(LIBATARI800_Sound_array + sound_array_fill, buffer, size);
+	sound_array_fill += size;
 }
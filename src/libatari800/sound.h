@@ -2,6 +2,7 @@
 #define LIBATARI800_SOUND_H_
 
 #include <stdio.h>
+#include <stdint.h>
 
 
 extern UBYTE *LIBATARI800_Sound_array;
@@ -10,6 +11,33 @@ extern unsigned int sound_array_fill;
 
 extern unsigned int sound_hw_buffer_size;
 
-extern double sample_residual;
+/* Position of the first sample of LIBATARI800_Sound_array since the sound
+   was set up, in samples and in CPU cycles, and the number of frames whose
+   sound is in the array. */
+extern uint64_t LIBATARI800_Sound_sample;
+extern uint64_t LIBATARI800_Sound_tick;
+extern int LIBATARI800_Sound_frames;
+
+/* Sets the number of frames collected in LIBATARI800_Sound_array, see
+   libatari800_set_sound_batch(). */
+void LIBATARI800_Sound_SetBatch(int frames);
+int LIBATARI800_Sound_GetBatch(void);
+
+/* Return and restore the sound timing for state saves. RESIDUAL is the
+   fraction of a sample carried to the next frame, in 1/0xffffffff units;
+   SAMPLE and TICK are the position of the next frame. */
+ULONG LIBATARI800_Sound_GetResidual(void);
+void LIBATARI800_Sound_GetPosition(uint64_t *sample, uint64_t *tick);
+void LIBATARI800_Sound_SetTiming(ULONG residual, uint64_t sample, uint64_t tick);
+
+/* Enables or disables lazy sound generation, see libatari800_set_lazy_sound(). */
+void LIBATARI800_Sound_SetLazy(int lazy);
+int LIBATARI800_Sound_GetLazy(void);
+
+/* Produces the sound of the last emulated frame, if that was postponed. */
+void LIBATARI800_Sound_Render(void);
+
+/* Called at the end of every frame instead of Sound_Update(). */
+void LIBATARI800_Sound_Update(void);
 
 #endif /* LIBATARI800_SOUND_H_ */
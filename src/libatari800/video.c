@@ -26,11 +26,104 @@
 #include <stdio.h>
 #include <string.h>
 
+#include "atari.h"
+#include "colours.h"
+#include "palette_expand.h"
 #include "platform.h"
 #include "screen.h"
 #include "libatari800/video.h"
 
-void PLATFORM_DisplayScreen(void){
+/* Render target set by LIBATARI800_Video_SetOutput; disabled when NULL. */
+static UBYTE *output_buffer = NULL;
+static int output_format;
+static int output_left;
+static int output_top;
+static int output_width;
+static int output_height;
+static int output_pitch;
+
+int LIBATARI800_Video_SetOutput(void *buffer, int format, int left, int top, int width, int height, int pitch)
+{
+	int bytes_per_pixel;
+	if (buffer == NULL) {
+		output_buffer = NULL;
+		return TRUE;
+	}
+	switch (format) {
+	case LIBATARI800_VIDEO_INDEXED8:
+		bytes_per_pixel = 1;
+		break;
+	case LIBATARI800_VIDEO_RGB565:
+		bytes_per_pixel = 2;
+		break;
+	case LIBATARI800_VIDEO_RGB24:
+		bytes_per_pixel = 3;
+		break;
+	case LIBATARI800_VIDEO_XRGB32:
+		bytes_per_pixel = 4;
+		break;
+	default:
+		return FALSE;
+	}
+	if (left < 0 || top < 0 || width <= 0 || height <= 0
+	    || left + width > Screen_WIDTH || top + height > Screen_HEIGHT)
+		return FALSE;
+	if (pitch == 0)
+		pitch = width * bytes_per_pixel;
+	else if (pitch < width * bytes_per_pixel)
+		return FALSE;
+	output_buffer = (UBYTE *) buffer;
+	output_format = format;
+	output_left = left;
+	output_top = top;
+	output_width = width;
+	output_height = height;
+	output_pitch = pitch;
+	return TRUE;
+}
+
+void PLATFORM_DisplayScreen(void)
+{
+	UBYTE const *src;
+	UBYTE *dest = output_buffer;
+	int y;
+
+	if (output_buffer == NULL)
+		return;
+
+	src = (UBYTE const *) Screen_atari + Screen_WIDTH * output_top + output_left;
+	switch (output_format) {
+	case LIBATARI800_VIDEO_INDEXED8:
+		for (y = 0; y < output_height; y++) {
+			memcpy(dest, src, output_width);
+			src += Screen_WIDTH;
+			dest += output_pitch;
+		}
+		break;
+	case LIBATARI800_VIDEO_RGB565:
+		{
+			/* Colours_table can change at any time, so the palette is
+			   converted on every frame. */
+			UWORD palette16[256];
+			int i;
+			for (i = 0; i < 256; i++) {
+				int rgb = Colours_table[i];
+				palette16[i] = (UWORD) (((rgb & 0x00f80000) >> 8) | ((rgb & 0x0000fc00) >> 5) | ((rgb & 0x000000f8) >> 3));
+			}
+			PALETTE_EXPAND_Blit16(dest, output_pitch, src, Screen_WIDTH, output_width, output_height, 1, 0, FALSE, palette16);
+		}
+		break;
+	case LIBATARI800_VIDEO_RGB24:
+		for (y = 0; y < output_height; y++) {
+			PALETTE_EXPAND_LineRGB24(dest, src, NULL, output_width, Colours_table);
+			src += Screen_WIDTH;
+			dest += output_pitch;
+		}
+		break;
+	default: /* LIBATARI800_VIDEO_XRGB32 */
+		/* Colours_table entries are already in 0x00RRGGBB format. */
+		PALETTE_EXPAND_Blit32(dest, output_pitch, src, Screen_WIDTH, output_width, output_height, 1, 0, FALSE, (ULONG const *) Colours_table);
+	}
 }
 
 int LIBATARI800_Video_Initialise(int *argc, char *argv[]) {
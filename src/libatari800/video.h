@@ -4,8 +4,14 @@
 #include <stdio.h>
 
 #include "config.h"
+#include "atari.h"
+#include "libatari800/libatari800.h"
 
 int LIBATARI800_Video_Initialise(int *argc, char *argv[]);
 void LIBATARI800_Video_Exit(void);
 
+/* Sets the buffer that receives the visible part of every emulated frame.
+   See libatari800_set_video_output() for a description of the parameters. */
+int LIBATARI800_Video_SetOutput(void *buffer, int format, int left, int top, int width, int height, int pitch);
+
 #endif /* LIBATARI800_VIDEO_H_ */
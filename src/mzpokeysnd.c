@@ -23,8 +23,10 @@
 */
 
 #include "config.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
 #include "asap_internal.h"
@@ -36,6 +38,16 @@
 #include "remez.h"
 #include "antic.h"
 #include "gtia.h"
+#ifndef ASAP
+#include "util.h"
+#include <time.h>
+#ifdef HAVE_UNISTD_H
+#include <unistd.h> /* getpid */
+#endif
+#endif
+#ifdef SOUND_THREADS
+#include "sndworker.h"
+#endif
 
 #define CONSOLE_VOL 8
 #ifdef NONLINEAR_MIXING
@@ -63,6 +75,16 @@ static const double pokeymix[61+CONSOLE_VOL] = { /* Nonlinear POKEY mixing array
 
 #define NPOKEYS 2
 
+/* Number of samples generated at once by generate_block */
+#define RESAM_BLOCK 256
+/* Number of samples per Pokey generated at once by mzpokeysnd_process_8/16.
+   Covers a whole buffer at the usual buffer sizes, so that a Pokey
+   generated on a worker thread needs one wakeup per buffer. */
+#define RESAM_BATCH 4096
+/* Length of the output accumulator of the polyphase resampler: a block
+   plus the longest filter phase */
+#define RESAM_ACC_SIZE (RESAM_BLOCK + SND_FILTER_SIZE)
+
 
 /* M_PI was not defined in MSVC headers */
 #ifndef M_PI
@@ -118,6 +140,31 @@ static double ticks_per_sample;
 static double samp_pos;
 #endif /* SYNCHRONIZED_SOUND */
 
+/* Polyphase form of filter_data, used by generate_block():
+   resam_filter[phase * resam_taps + k] = filter_data[phase + k * resam_ticks],
+   or 0 past the end of the change queue (age filter_size - 1). */
+static int resam_ticks; /* Pokey ticks per output sample */
+static int resam_taps;  /* 0 if the polyphase resampler can't be used */
+static float resam_filter[2 * SND_FILTER_SIZE];
+
+/* Integer form of resam_filter, used instead of it when
+   MZPOKEYSND_fixed_point is set. The taps include the output scaling:
+   a level change with RESAM_LEVEL_BITS fraction bits, multiplied by a tap,
+   gives output sample units with resam_fix_bits fraction bits. */
+#ifdef NONLINEAR_MIXING
+#define RESAM_LEVEL_BITS 6
+#define LEVEL_FIX(v) ((SLONG) ((v) * (1 << RESAM_LEVEL_BITS) + 0.5))
+#else
+#define RESAM_LEVEL_BITS 0
+#define LEVEL_FIX(v) ((SLONG) (v))
+#endif
+static SLONG resam_filter_fix[2 * SND_FILTER_SIZE];
+static int resam_fix_bits;
+static SLONG resam_fix_scale; /* output of level 1, with resam_fix_bits fraction bits */
+static int resam_fixed = 0;   /* mode in which the accumulators were built */
+
+int MZPOKEYSND_fixed_point = FALSE;
+
 /* State variables for single Pokey Chip */
 typedef struct stPokeyState
 {
@@ -262,6 +309,15 @@ typedef struct stPokeyState
 
     int speaker;
 
+    /* Polyphase resampler state. Every volume change from the change queue
+       is added, once, to all future output samples it affects. */
+    float resam_acc[RESAM_ACC_SIZE]; /* accumulated future output samples */
+    SLONG resam_acc_fix[RESAM_ACC_SIZE]; /* the same in fixed point */
+    int resam_pos;    /* resam_acc index of the sample being generated */
+    int resam_next;   /* first queue entry not added to resam_acc yet */
+    qev_t resam_vol;  /* output volume after the last added queue entry */
+    int resam_valid;  /* FALSE if resam_acc must be rebuilt from the queue */
+
 } PokeyState;
 
 PokeyState pokey_states[NPOKEYS];
@@ -297,6 +353,7 @@ static void ResetPokeyState(PokeyState* ps)
     ps->ovola = 0;
     ps->qebeg = 0;
     ps->qeend = 0;
+    ps->resam_valid = 0;
 
     /* Global Pokey controls */
     ps->mdivk = 28;
@@ -1145,6 +1202,20 @@ static void advance_ticks(PokeyState* ps, int ticks)
     }
 }
 
+/* Returns TRUE if none of the channels can change the Pokey's output until
+   the next register write, ie. they are all volume-only or silent. */
+static int output_steady(PokeyState* ps)
+{
+    if(ps->forcero)
+        return 0;
+#ifdef NONLINEAR_MIXING
+    return (ps->c0vo || ps->vol0 == 0) && (ps->c1vo || ps->vol1 == 0)
+        && (ps->c2vo || ps->vol2 == 0) && (ps->c3vo || ps->vol3 == 0);
+#else
+    return ps->c0stop && ps->c1stop && ps->c2stop && ps->c3stop;
+#endif
+}
+
 static double generate_sample(PokeyState* ps)
 {
     /*unsigned long ta = (subticks+pokey_frq)/POKEYSND_playback_freq;
@@ -1154,6 +1225,211 @@ static double generate_sample(PokeyState* ps)
     return read_resam_all(ps);
 }
 
+/* Block resampler. Instead of summing all queued volume changes for every
+   output sample, as read_resam_all() does, each change is multiplied by one
+   phase of the filter and added to the output samples ahead. The inner
+   loop works on contiguous floats and is easily vectorised. The result is
+   the same as of generate_sample(), up to rounding. */
+
+static void build_resam_filter(void)
+{
+    int phase, k;
+
+    resam_ticks = pokey_frq/POKEYSND_playback_freq;
+    if(resam_ticks < 1 || resam_ticks >= filter_size - 1)
+    {
+        resam_taps = 0; /* use generate_sample() */
+        return;
+    }
+    resam_taps = (filter_size - 2)/resam_ticks + 1;
+    for(phase=0; phase<resam_ticks; phase++)
+    {
+        for(k=0; k<resam_taps; k++)
+        {
+            int age = phase + k*resam_ticks;
+            resam_filter[phase*resam_taps + k] =
+                age <= filter_size - 2 ? (float)filter_data[age] : 0.0f;
+        }
+    }
+}
+
+static void resam_add(float *acc, const float *filter, float delta, int n)
+{
+    /* All loads before stores, so that the compiler can use vector
+       instructions without checking for aliasing. */
+    while(n >= 4)
+    {
+        float a0 = acc[0] + delta*filter[0];
+        float a1 = acc[1] + delta*filter[1];
+        float a2 = acc[2] + delta*filter[2];
+        float a3 = acc[3] + delta*filter[3];
+        acc[0] = a0;
+        acc[1] = a1;
+        acc[2] = a2;
+        acc[3] = a3;
+        acc += 4;
+        filter += 4;
+        n -= 4;
+    }
+    while(n > 0)
+    {
+        *acc++ += delta*(*filter++);
+        n--;
+    }
+}
+
+static void resam_add_fix(SLONG *acc, const SLONG *filter, SLONG delta, int n)
+{
+    while(n >= 4)
+    {
+        SLONG a0 = acc[0] + delta*filter[0];
+        SLONG a1 = acc[1] + delta*filter[1];
+        SLONG a2 = acc[2] + delta*filter[2];
+        SLONG a3 = acc[3] + delta*filter[3];
+        acc[0] = a0;
+        acc[1] = a1;
+        acc[2] = a2;
+        acc[3] = a3;
+        acc += 4;
+        filter += 4;
+        n -= 4;
+    }
+    while(n > 0)
+    {
+        *acc++ += delta*(*filter++);
+        n--;
+    }
+}
+
+/* Adds queue entries not processed yet to the accumulator. ps->curtick is
+   the time of the output sample at ps->resam_pos. */
+static void resam_spread(PokeyState* ps)
+{
+    while(ps->resam_next != ps->qeend)
+    {
+        int i = ps->resam_next;
+        int age = ps->curtick - ps->qet[i];
+        qev_t prev = ps->resam_vol;
+
+        ps->resam_vol = ps->qev[i];
+        /* Entries older than the queue length don't contribute any more. */
+        if(age <= filter_size - 2)
+        {
+            int k = age/resam_ticks;
+            int offset = (age - k*resam_ticks)*resam_taps + k;
+            if(resam_fixed)
+                resam_add_fix(ps->resam_acc_fix + ps->resam_pos,
+                              resam_filter_fix + offset,
+                              LEVEL_FIX(prev) - LEVEL_FIX(ps->resam_vol),
+                              resam_taps - k);
+            else
+                resam_add(ps->resam_acc + ps->resam_pos,
+                          resam_filter + offset,
+                          (float)(prev - ps->resam_vol), resam_taps - k);
+        }
+        if(++ps->resam_next >= filter_size)
+            ps->resam_next = 0;
+    }
+}
+
+/* Generates N (at most RESAM_BLOCK) consecutive output samples of a Pokey
+   into OUT. Returns the number of samples generated by the fast path, for
+   POKEYSND_fast_samples. Only accesses PS, so that several Pokeys can be
+   generated in parallel. */
+static int generate_block(PokeyState* ps, float *out, int n)
+{
+    int i;
+    int fast = 0;
+
+    if(resam_taps == 0)
+    {
+        for(i=0; i<n; i++)
+            out[i] = (float)generate_sample(ps);
+        return 0;
+    }
+    if(!ps->resam_valid)
+    {
+        /* Entries still in the queue are added with the first sample. */
+        for(i=0; i<RESAM_ACC_SIZE; i++)
+            ps->resam_acc[i] = 0.0f;
+        ps->resam_next = ps->qebeg;
+        ps->resam_vol = ps->ovola;
+        ps->resam_valid = 1;
+    }
+    if(ps->resam_next == ps->qeend && output_steady(ps))
+    {
+        /* No new changes can appear during the block, so the Pokey is
+           advanced in one step and only earlier changes are added. */
+        float level = (float)(ps->resam_vol*filter_data[0]);
+        advance_ticks(ps, n*resam_ticks);
+        for(i=0; i<n; i++)
+            out[i] = level + ps->resam_acc[i];
+        fast = n;
+    }
+    else
+    {
+        for(i=0; i<n; i++)
+        {
+            ps->resam_pos = i;
+            advance_ticks(ps, resam_ticks);
+            resam_spread(ps);
+            out[i] = (float)(ps->resam_vol*filter_data[0]) + ps->resam_acc[i];
+        }
+    }
+    /* Move the samples ahead to the beginning of the accumulator. */
+    memmove(ps->resam_acc, ps->resam_acc + n, resam_taps*sizeof(float));
+    for(i=resam_taps; i<resam_taps + n; i++)
+        ps->resam_acc[i] = 0.0f;
+    return fast;
+}
+
+/* The same as generate_block(), in fixed point. OUT receives output
+   samples with resam_fix_bits fraction bits, scaled for the output
+   format. */
+static int generate_block_fix(PokeyState* ps, SLONG *out, int n)
+{
+    int i;
+    int fast = 0;
+
+    if(resam_taps == 0)
+    {
+        for(i=0; i<n; i++)
+            out[i] = (SLONG)floor(generate_sample(ps)*resam_fix_scale + 0.5);
+        return 0;
+    }
+    if(!ps->resam_valid)
+    {
+        for(i=0; i<RESAM_ACC_SIZE; i++)
+            ps->resam_acc_fix[i] = 0;
+        ps->resam_next = ps->qebeg;
+        ps->resam_vol = ps->ovola;
+        ps->resam_valid = 1;
+    }
+    if(ps->resam_next == ps->qeend && output_steady(ps))
+    {
+        SLONG level = LEVEL_FIX(ps->resam_vol)*resam_filter_fix[0];
+        advance_ticks(ps, n*resam_ticks);
+        for(i=0; i<n; i++)
+            out[i] = level + ps->resam_acc_fix[i];
+        fast = n;
+    }
+    else
+    {
+        for(i=0; i<n; i++)
+        {
+            ps->resam_pos = i;
+            advance_ticks(ps, resam_ticks);
+            resam_spread(ps);
+            out[i] = LEVEL_FIX(ps->resam_vol)*resam_filter_fix[0]
+                     + ps->resam_acc_fix[i];
+        }
+    }
+    memmove(ps->resam_acc_fix, ps->resam_acc_fix + n, resam_taps*sizeof(SLONG));
+    for(i=resam_taps; i<resam_taps + n; i++)
+        ps->resam_acc_fix[i] = 0;
+    return fast;
+}
+
 /******************************************
  filter table generator by Krzysztof Nikiel
  ******************************************/
@@ -1258,8 +1534,175 @@ found:
   return size;
 }
 
+/* Filters computed by remez_filter_table() are kept for later inits with
+   the same parameters, and optionally stored in files in
+   MZPOKEYSND_filter_cache_dir. Cache entries are never modified. */
+typedef struct filter_cache_t {
+    struct filter_cache_t *next;
+    int quality;
+    int pokey_frq;
+    int playback_freq;
+    int size;
+    double cutoff;
+    double *data;
+} filter_cache_t;
+
+#define FILTER_CACHE_MAX 8
+#define FILTER_FILE_MAGIC "A8MZFLT1"
+
+static filter_cache_t *filter_cache = NULL;
+static int filter_cache_len = 0;
+
+char MZPOKEYSND_filter_cache_dir[FILENAME_MAX] = "";
+
+static void add_to_filter_cache(int quality, int playback_freq, int size, double cutoff)
+{
+    filter_cache_t *entry;
+
+    if(filter_cache_len >= FILTER_CACHE_MAX)
+        return;
+    entry = (filter_cache_t *)malloc(sizeof(filter_cache_t));
+    if(entry == NULL)
+        return;
+    entry->data = (double *)malloc(size*sizeof(double));
+    if(entry->data == NULL)
+    {
+        free(entry);
+        return;
+    }
+    memcpy(entry->data, filter_data, size*sizeof(double));
+    entry->quality = quality;
+    entry->pokey_frq = pokey_frq;
+    entry->playback_freq = playback_freq;
+    entry->size = size;
+    entry->cutoff = cutoff;
+    entry->next = filter_cache;
+    filter_cache = entry;
+    filter_cache_len++;
+}
+
+#ifndef ASAP
+/* A filter file holds FILTER_FILE_MAGIC, the ints quality, pokey_frq,
+   playback_freq and size, the double 1/3 (to detect files written on
+   a machine with a different double format), the cutoff and the filter,
+   all in the native format. */
+static void filter_file_name(char *filename, int quality, int playback_freq)
+{
+    char name[64];
+    sprintf(name, "mzfilter-q%d-%d-%d.bin", quality, pokey_frq, playback_freq);
+    Util_catpath(filename, MZPOKEYSND_filter_cache_dir, name);
+}
+
+static int read_filter_file(int quality, int playback_freq, double *cutoff)
+{
+    char filename[FILENAME_MAX];
+    char magic[sizeof(FILTER_FILE_MAGIC) - 1];
+    int header[4];
+    double check;
+    FILE *fp;
+    int size = 0;
+
+    filter_file_name(filename, quality, playback_freq);
+    fp = fopen(filename, "rb");
+    if(fp == NULL)
+        return 0;
+    if(fread(magic, sizeof(magic), 1, fp) == 1
+       && memcmp(magic, FILTER_FILE_MAGIC, sizeof(magic)) == 0
+       && fread(header, sizeof(header), 1, fp) == 1
+       && header[0] == quality && header[1] == pokey_frq
+       && header[2] == playback_freq
+       && header[3] > 0 && header[3] <= SND_FILTER_SIZE
+       && fread(&check, sizeof(check), 1, fp) == 1 && check == 1.0/3.0
+       && fread(cutoff, sizeof(double), 1, fp) == 1
+       && fread(filter_data, sizeof(double), header[3], fp) == (size_t)header[3])
+        size = header[3];
+    fclose(fp);
+    return size;
+}
+
+/* The file is written under a temporary name in the same directory and
+   then renamed, so that another instance never reads a partly written
+   file, and a crash doesn't leave one behind. */
+static void write_filter_file(int quality, int playback_freq, int size, double cutoff)
+{
+    char filename[FILENAME_MAX];
+    char tmpname[FILENAME_MAX + 32];
+    int header[4];
+    double check = 1.0/3.0;
+    FILE *fp;
+    int ok;
+
+    filter_file_name(filename, quality, playback_freq);
+    /* unique to this process, so that instances don't share the file */
+#ifdef HAVE_UNISTD_H
+    sprintf(tmpname, "%s.%lx.tmp", filename, (unsigned long)getpid());
+#else
+    sprintf(tmpname, "%s.%lx.tmp", filename, (unsigned long)time(NULL) ^ (unsigned long)clock());
+#endif
+    fp = fopen(tmpname, "wb");
+    if(fp == NULL)
+        return;
+    header[0] = quality;
+    header[1] = pokey_frq;
+    header[2] = playback_freq;
+    header[3] = size;
+    ok = fwrite(FILTER_FILE_MAGIC, sizeof(FILTER_FILE_MAGIC) - 1, 1, fp) == 1
+         && fwrite(header, sizeof(header), 1, fp) == 1
+         && fwrite(&check, sizeof(check), 1, fp) == 1
+         && fwrite(&cutoff, sizeof(cutoff), 1, fp) == 1
+         && fwrite(filter_data, sizeof(double), size, fp) == (size_t)size;
+    if(fclose(fp) != 0)
+        ok = 0;
+    /* rename() fails on some systems if another instance has created the
+       file meanwhile; that file is as good as ours. */
+    if(!ok || rename(tmpname, filename) != 0)
+        remove(tmpname);
+}
+#endif /* ASAP */
+
+/* Fills filter_data for resampling from pokey_frq to PLAYBACK_FREQ, like
+   remez_filter_table(), but takes the filter from the cache if possible. */
+static int cached_filter_table(int playback_freq, double *cutoff, int quality)
+{
+    filter_cache_t *entry;
+    int size;
+
+    for(entry = filter_cache; entry != NULL; entry = entry->next)
+    {
+        if(entry->quality == quality && entry->pokey_frq == pokey_frq
+           && entry->playback_freq == playback_freq)
+        {
+            memcpy(filter_data, entry->data, entry->size*sizeof(double));
+            *cutoff = entry->cutoff;
+            return entry->size;
+        }
+    }
+#ifndef ASAP
+    if(MZPOKEYSND_filter_cache_dir[0] != '\0')
+    {
+        size = read_filter_file(quality, playback_freq, cutoff);
+        if(size > 0)
+        {
+            add_to_filter_cache(quality, playback_freq, size, *cutoff);
+            return size;
+        }
+    }
+#endif
+    size = remez_filter_table((double)playback_freq/pokey_frq, cutoff, quality);
+    if(size > 0)
+    {
+        add_to_filter_cache(quality, playback_freq, size, *cutoff);
+#ifndef ASAP
+        if(MZPOKEYSND_filter_cache_dir[0] != '\0')
+            write_filter_file(quality, playback_freq, size, *cutoff);
+#endif
+    }
+    return size;
+}
+
 static void mzpokeysnd_process_8(void* sndbuffer, int sndn);
 static void mzpokeysnd_process_16(void* sndbuffer, int sndn);
+static void build_resam_filter_fix(int flags);
 static void Update_pokey_sound_mz(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain);
 #ifdef SERIO_SOUND
 static void Update_serio_sound_mz(int out, UBYTE data);
@@ -1404,10 +1847,13 @@ int MZPOKEYSND_Init(ULONG freq17, int playback_freq, UBYTE num_pokeys,
     default:
         pokey_frq = (int)(((double)pokey_frq_ideal/POKEYSND_playback_freq) + 0.5)
           * POKEYSND_playback_freq;
-	filter_size = remez_filter_table((double)POKEYSND_playback_freq/pokey_frq,
-					 &cutoff, quality);
+	filter_size = cached_filter_table(POKEYSND_playback_freq, &cutoff, quality);
 	audible_frq = (int ) (cutoff * pokey_frq);
     }
+    build_resam_filter();
+    build_resam_filter_fix(flags);
+    pokey_states[0].resam_valid = 0;
+    pokey_states[1].resam_valid = 0;
 
     build_poly4();
     build_poly5();
@@ -2316,6 +2762,140 @@ void mzpokeysnd_debugreset(UBYTE chip)
 
 #define MAX_SAMPLE 152
 
+static float resam_out[NPOKEYS][RESAM_BATCH];
+static SLONG resam_out_fix[NPOKEYS][RESAM_BATCH];
+
+/* Output scale factors of mzpokeysnd_process_8/16. */
+#define OUT_SCALE_8 (255.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95)
+#define OUT_SCALE_16 (65535.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95)
+
+/* Fraction bits of fixed point output samples. The largest output,
+   MAX_SAMPLE times the scale factor (below 2^6.6 for 8-bit and 2^14.6 for
+   16-bit) plus the filter's overshoot, must fit in an SLONG, and with
+   FIX_OFFSET added, in an ULONG. */
+#define FIX_BITS_8 23
+#define FIX_BITS_16 15
+/* Added before shifting right, so that the shifted value is never
+   negative. */
+#define FIX_OFFSET 0x40000000UL
+
+/* Fills resam_filter_fix from resam_filter, for the output format given
+   by FLAGS. */
+static void build_resam_filter_fix(int flags)
+{
+    double scale;
+    int i;
+
+    if(flags & POKEYSND_BIT16)
+    {
+        resam_fix_bits = FIX_BITS_16;
+        scale = OUT_SCALE_16;
+    }
+    else
+    {
+        resam_fix_bits = FIX_BITS_8;
+        scale = OUT_SCALE_8;
+    }
+    scale *= 1 << resam_fix_bits;
+    resam_fix_scale = (SLONG)floor(scale + 0.5);
+    scale /= 1 << RESAM_LEVEL_BITS;
+    for(i=0; i<resam_ticks*resam_taps; i++)
+        resam_filter_fix[i] = (SLONG)floor(resam_filter[i]*scale + 0.5);
+}
+
+/* Linear congruential generator for dithering in fixed point mode,
+   which is cheaper than rand() and doesn't need floating point. */
+static ULONG dither_seed = 1;
+
+/* Converts a fixed point sample to an integer, with the same rounding and
+   dither as the floating point conversion: floor(x + 0.5 + [-0.25, 0.25)). */
+static SLONG fix_to_int(SLONG x)
+{
+    ULONG u;
+    dither_seed = dither_seed*1664525 + 1013904223;
+    u = (ULONG)x + FIX_OFFSET + ((ULONG)1 << (resam_fix_bits - 1))
+        + (dither_seed >> (33 - resam_fix_bits)) - ((ULONG)1 << (resam_fix_bits - 2));
+    return (SLONG)(u >> resam_fix_bits) - (SLONG)(FIX_OFFSET >> resam_fix_bits);
+}
+
+#ifdef SOUND_THREADS
+/* Below this number of samples per Pokey, waking up a worker thread costs
+   more than generating the samples, so all Pokeys are generated on the
+   calling thread. */
+#define THREAD_MIN_SAMPLES 512
+#endif
+
+/* Generation of one Pokey's batch, possibly on a worker thread. */
+typedef struct {
+    int pokey;
+    int n;      /* number of samples to generate */
+    int fast;   /* sum of the results of generate_block */
+#ifdef SOUND_THREADS
+    int worker; /* job number from SNDWORKER_Start */
+#endif
+} block_job_t;
+
+static block_job_t block_jobs[NPOKEYS];
+
+static void generate_block_job(void *arg)
+{
+    block_job_t *job = (block_job_t *) arg;
+    PokeyState *ps = pokey_states + job->pokey;
+    int i, n;
+
+    job->fast = 0;
+    for(i=0; i<job->n; i+=n)
+    {
+        n = job->n - i;
+        if(n > RESAM_BLOCK)
+            n = RESAM_BLOCK;
+        if(resam_fixed)
+            job->fast += generate_block_fix(ps, resam_out_fix[job->pokey] + i, n);
+        else
+            job->fast += generate_block(ps, resam_out[job->pokey] + i, n);
+    }
+}
+
+/* Fills resam_out (or resam_out_fix, in fixed point mode) with up to
+   RESAM_BATCH samples of each Pokey, for a buffer of NSAM samples.
+   Returns the number of samples per Pokey. */
+static int generate_blocks(int nsam)
+{
+    int i;
+    int n = nsam / num_cur_pokeys;
+    if(n > RESAM_BATCH)
+        n = RESAM_BATCH;
+    if(resam_fixed != MZPOKEYSND_fixed_point)
+    {
+        /* Switching modes: rebuild the accumulators from the queue. */
+        resam_fixed = MZPOKEYSND_fixed_point;
+        for(i=0; i<num_cur_pokeys; i++)
+            pokey_states[i].resam_valid = 0;
+    }
+    for(i=0; i<num_cur_pokeys; i++)
+    {
+        block_jobs[i].pokey = i;
+        block_jobs[i].n = n;
+    }
+#ifdef SOUND_THREADS
+    if(n >= THREAD_MIN_SAMPLES)
+    {
+        /* Pokeys other than the first are generated on worker threads. */
+        for(i=1; i<num_cur_pokeys; i++)
+            block_jobs[i].worker = SNDWORKER_Start(generate_block_job, block_jobs + i);
+        generate_block_job(block_jobs);
+        for(i=1; i<num_cur_pokeys; i++)
+            SNDWORKER_Wait(block_jobs[i].worker);
+    }
+    else
+#endif
+    for(i=0; i<num_cur_pokeys; i++)
+        generate_block_job(block_jobs + i);
+    for(i=0; i<num_cur_pokeys; i++)
+        POKEYSND_fast_samples += block_jobs[i].fast;
+    return n;
+}
+
 static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
 {
     int i;
@@ -2329,39 +2909,58 @@ static void mzpokeysnd_process_8(void* sndbuffer, int sndn)
        we assume even sndn */
     while(nsam >= (int) num_cur_pokeys)
     {
-#ifdef VOL_ONLY_SOUND
-        if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
-            { int l;
-            if( POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]>0 )
-                POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]-=1280;
-            while(  (l=POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr])<=0 )
-                {	POKEYSND_sampout=POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
-                        POKEYSND_sampbuf_rptr++;
-                        if( POKEYSND_sampbuf_rptr>=POKEYSND_SAMPBUF_MAX )
-                                POKEYSND_sampbuf_rptr=0;
-                        if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
-                            {
-                            POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]+=l;
-                            }
-                        else	break;
+        int n = generate_blocks(nsam);
+        int j;
+        for(j=0; j<n; j++)
+        {
+    #ifdef VOL_ONLY_SOUND
+            if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
+                { int l;
+                if( POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]>0 )
+                    POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]-=1280;
+                while(  (l=POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr])<=0 )
+                    {	POKEYSND_sampout=POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
+                            POKEYSND_sampbuf_rptr++;
+                            if( POKEYSND_sampbuf_rptr>=POKEYSND_SAMPBUF_MAX )
+                                    POKEYSND_sampbuf_rptr=0;
+                            if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
+                                {
+                                POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]+=l;
+                                }
+                            else	break;
+                    }
                 }
-            }
-#endif
+    #endif
 
+            if(resam_fixed)
+            {
 #ifdef VOL_ONLY_SOUND
-        buffer[0] = (UBYTE)floor((generate_sample(pokey_states) + POKEYSND_sampout)
-         * (255.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                buffer[0] = (UBYTE)(fix_to_int(resam_out_fix[0][j]
+                 + POKEYSND_sampout*resam_fix_scale) + 128);
 #else
-        buffer[0] = (UBYTE)floor(generate_sample(pokey_states)
-         * (255.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                buffer[0] = (UBYTE)(fix_to_int(resam_out_fix[0][j]) + 128);
 #endif
-        for(i=1; i<num_cur_pokeys; i++)
-        {
-            buffer[i] = (UBYTE)floor(generate_sample(pokey_states + i)
-             * (255.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                for(i=1; i<num_cur_pokeys; i++)
+                    buffer[i] = (UBYTE)(fix_to_int(resam_out_fix[i][j]) + 128);
+            }
+            else
+            {
+#ifdef VOL_ONLY_SOUND
+                buffer[0] = (UBYTE)floor((resam_out[0][j] + POKEYSND_sampout)
+                 * OUT_SCALE_8 + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+#else
+                buffer[0] = (UBYTE)floor(resam_out[0][j]
+                 * OUT_SCALE_8 + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+#endif
+                for(i=1; i<num_cur_pokeys; i++)
+                {
+                    buffer[i] = (UBYTE)floor(resam_out[i][j]
+                     * OUT_SCALE_8 + 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                }
+            }
+            buffer += num_cur_pokeys;
         }
-        buffer += num_cur_pokeys;
-        nsam -= num_cur_pokeys;
+        nsam -= n * num_cur_pokeys;
     }
 }
 
@@ -2378,38 +2977,57 @@ static void mzpokeysnd_process_16(void* sndbuffer, int sndn)
        we assume even sndn */
     while(nsam >= (int) num_cur_pokeys)
     {
-#ifdef VOL_ONLY_SOUND
-        if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
-            { int l;
-            if( POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]>0 )
-                POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]-=1280;
-            while(  (l=POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr])<=0 )
-                {	POKEYSND_sampout=POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
-                        POKEYSND_sampbuf_rptr++;
-                        if( POKEYSND_sampbuf_rptr>=POKEYSND_SAMPBUF_MAX )
-                                POKEYSND_sampbuf_rptr=0;
-                        if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
-                            {
-                            POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]+=l;
-                            }
-                        else	break;
+        int n = generate_blocks(nsam);
+        int j;
+        for(j=0; j<n; j++)
+        {
+    #ifdef VOL_ONLY_SOUND
+            if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
+                { int l;
+                if( POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]>0 )
+                    POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]-=1280;
+                while(  (l=POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr])<=0 )
+                    {	POKEYSND_sampout=POKEYSND_sampbuf_val[POKEYSND_sampbuf_rptr];
+                            POKEYSND_sampbuf_rptr++;
+                            if( POKEYSND_sampbuf_rptr>=POKEYSND_SAMPBUF_MAX )
+                                    POKEYSND_sampbuf_rptr=0;
+                            if( POKEYSND_sampbuf_rptr!=POKEYSND_sampbuf_ptr )
+                                {
+                                POKEYSND_sampbuf_cnt[POKEYSND_sampbuf_rptr]+=l;
+                                }
+                            else	break;
+                    }
                 }
-            }
+    #endif
+            if(resam_fixed)
+            {
+#ifdef VOL_ONLY_SOUND
+                buffer[0] = (SWORD)fix_to_int(resam_out_fix[0][j]
+                 + POKEYSND_sampout*resam_fix_scale);
+#else
+                buffer[0] = (SWORD)fix_to_int(resam_out_fix[0][j]);
 #endif
+                for(i=1; i<num_cur_pokeys; i++)
+                    buffer[i] = (SWORD)fix_to_int(resam_out_fix[i][j]);
+            }
+            else
+            {
 #ifdef VOL_ONLY_SOUND
-        buffer[0] = (SWORD)floor((generate_sample(pokey_states) + POKEYSND_sampout)
-         * (65535.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                buffer[0] = (SWORD)floor((resam_out[0][j] + POKEYSND_sampout)
+                 * OUT_SCALE_16 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
 #else
-        buffer[0] = (SWORD)floor(generate_sample(pokey_states)
-         * (65535.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                buffer[0] = (SWORD)floor(resam_out[0][j]
+                 * OUT_SCALE_16 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
 #endif
-        for(i=1; i<num_cur_pokeys; i++)
-        {
-            buffer[i] = (SWORD)floor(generate_sample(pokey_states + i)
-             * (65535.0 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95) + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                for(i=1; i<num_cur_pokeys; i++)
+                {
+                    buffer[i] = (SWORD)floor(resam_out[i][j]
+                     * OUT_SCALE_16 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25);
+                }
+            }
+            buffer += num_cur_pokeys;
         }
-        buffer += num_cur_pokeys;
-        nsam -= num_cur_pokeys;
+        nsam -= n * num_cur_pokeys;
     }
 }
 
@@ -2421,6 +3039,8 @@ static void generate_sync(unsigned int num_ticks)
 	UBYTE *buffer = POKEYSND_process_buffer + POKEYSND_process_buffer_fill;
 	UBYTE *buffer_end = POKEYSND_process_buffer + POKEYSND_process_buffer_length;
 	unsigned int i;
+	/* ticks not yet applied to Pokeys whose output is steady */
+	unsigned int pending[NPOKEYS] = {0};
 
 	for (;;) {
 		double int_part;
@@ -2438,11 +3058,23 @@ static void generate_sync(unsigned int num_ticks)
 		num_ticks -= ticks;
 
 		for (i = 0; i < num_cur_pokeys; ++i) {
-			/* advance pokey to the new position and produce a sample */
-			advance_ticks(pokey_states + i, ticks);
+			double sample;
+			if (pokey_states[i].qebeg == pokey_states[i].qeend && output_steady(pokey_states + i)) {
+				/* empty queue and no changes coming: the advance can wait */
+				pending[i] += ticks;
+				sample = pokey_states[i].ovola * interp_filter_data(0, samp_pos);
+				POKEYSND_fast_samples++;
+			}
+			else {
+				/* advance pokey to the new position and produce a sample */
+				advance_ticks(pokey_states + i, pending[i] + ticks);
+				pending[i] = 0;
+				sample = interp_read_resam_all(pokey_states + i, samp_pos);
+			}
+			pokey_states[i].resam_valid = 0;
 			if (POKEYSND_snd_flags & POKEYSND_BIT16) {
 				*((SWORD *)buffer) = (SWORD)floor(
-					interp_read_resam_all(pokey_states + i, samp_pos)
+					sample
 					* (volume.s16 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95)
 					+ 0.5 + 0.5 * rand() / RAND_MAX - 0.25
 				);
@@ -2450,7 +3082,7 @@ static void generate_sync(unsigned int num_ticks)
 			}
 			else
 				*buffer++ = (UBYTE)floor(
-					interp_read_resam_all(pokey_states + i, samp_pos)
+					sample
 					* (volume.s8 / 2 / MAX_SAMPLE / 4 * M_PI * 0.95)
 					+ 128 + 0.5 + 0.5 * rand() / RAND_MAX - 0.25
 				);
@@ -2458,11 +3090,9 @@ static void generate_sync(unsigned int num_ticks)
 	}
 
 	POKEYSND_process_buffer_fill = buffer - POKEYSND_process_buffer;
-	if (num_ticks > 0) {
-		/* remaining ticks */
-		for (i = 0; i < num_cur_pokeys; ++i)
-			advance_ticks(pokey_states + i, num_ticks);
-	}
+	/* remaining ticks */
+	for (i = 0; i < num_cur_pokeys; ++i)
+		advance_ticks(pokey_states + i, pending[i] + num_ticks);
 }
 #endif /* SYNCHRONIZED_SOUND */
 
@@ -1,8 +1,22 @@
 #ifndef MZPOKEYSND_H_
 #define MZPOKEYSND_H_
 
+#include <stdio.h> /* FILENAME_MAX */
 #include "atari.h"
 
+/* When TRUE, the polyphase resampler and the output conversion use fixed
+   point arithmetic instead of floating point. The Pokey state is not
+   affected: with NONLINEAR_MIXING the levels in the change queue stay
+   doubles, and so does the direct filter used when the polyphase
+   resampler can't be. The output differs from the floating point one by
+   rounding only. May be changed at any time. */
+extern int MZPOKEYSND_fixed_point;
+
+/* Directory where computed resampling filters are stored, so that they
+   don't have to be computed again by later runs. Empty to disable.
+   Filters are also cached in memory for the whole run. */
+extern char MZPOKEYSND_filter_cache_dir[FILENAME_MAX];
+
 int MZPOKEYSND_Init(ULONG freq17,
                         int playback_freq,
                         UBYTE num_pokeys,
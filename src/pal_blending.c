@@ -24,6 +24,8 @@
 
 #include "pal_blending.h"
 
+#include <string.h>
+
 #include "artifact.h"
 #include "atari.h"
 #include "colours.h"
@@ -35,16 +37,70 @@
 #include "videomode.h"
 #endif /* SUPPORTS_CHANGE_VIDEOMODE */
 
+/* Blended output colours, precomputed for every combination of the current
+   pixel's colour and the previous line's hue. Index with
+   BLEND_INDEX(previous, current); the first dimension is the parity of the
+   current line. Each entry already contains the average of the current
+   line's colour and the previous line's colour taken with the current
+   pixel's luminance, so a blitter needs one lookup per pixel. */
 static union {
-	UWORD bpp16[2][256];	/* 16-bit palette */
-	ULONG bpp32[2][256];	/* 32-bit palette */
-} palette;
+	UWORD bpp16[2][16*256];	/* 16-bit blended palette */
+	ULONG bpp32[2][16*256];	/* 32-bit blended palette */
+} blend;
 
-static ULONG shift_mask;
+#define BLEND_INDEX(prev, cur) ((((prev) & 0xf0) << 4) | (cur))
+
+/* Fills BLEND.BPP16 from the even and odd line palettes PAL. */
+static void FillBlendTable16(UWORD pal[2][256], ULONG shift_mask)
+{
+	int odd;
+	for (odd = 0; odd < 2; ++odd) {
+		UWORD const *cur_pal = pal[odd];
+		UWORD const *prev_pal = pal[odd ^ 1];
+		UWORD *table = blend.bpp16[odd];
+		int hue_prev;
+		int c;
+		for (hue_prev = 0; hue_prev < 16; ++hue_prev)
+			for (c = 0; c < 256; ++c) {
+				/* Make QUAD_PREV have the same Y component as the current line's pixel. */
+				ULONG quad_prev = prev_pal[(hue_prev << 4) | (c & 0x0f)];
+				ULONG quad = cur_pal[c];
+				/* Since QUAD_PREV and QUAD have the same Y component, computing
+				   averages of even U/V and odd U/V is equal to computing averages
+				   of even and odd RGB components. */
+				table[(hue_prev << 8) | c] = (UWORD) ((quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1));
+			}
+	}
+}
+
+/* Fills BLEND.BPP32 from the even and odd line palettes PAL. */
+static void FillBlendTable32(ULONG pal[2][256], ULONG shift_mask)
+{
+	int odd;
+	for (odd = 0; odd < 2; ++odd) {
+		ULONG const *cur_pal = pal[odd];
+		ULONG const *prev_pal = pal[odd ^ 1];
+		ULONG *table = blend.bpp32[odd];
+		int hue_prev;
+		int c;
+		for (hue_prev = 0; hue_prev < 16; ++hue_prev)
+			for (c = 0; c < 256; ++c) {
+				/* See the comments in FillBlendTable16(). */
+				ULONG quad_prev = prev_pal[(hue_prev << 4) | (c & 0x0f)];
+				ULONG quad = cur_pal[c];
+				table[(hue_prev << 8) | c] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
+			}
+	}
+}
 
 void PAL_BLENDING_UpdateLookup(void)
 {
 	if (ARTIFACT_mode == ARTIFACT_PAL_BLEND) {
+		union {
+			UWORD bpp16[2][256];	/* 16-bit palette */
+			ULONG bpp32[2][256];	/* 32-bit palette */
+		} palette;
+		ULONG shift_mask;
 		double yuv_table[256*5];
 		int even_pal[256];
 		int odd_pal[256];
@@ -84,92 +140,75 @@ void PAL_BLENDING_UpdateLookup(void)
 		}
 		PLATFORM_GetPixelFormat(&format);
 		shift_mask = (format.rmask & ~(format.rmask << 1)) | (format.gmask & ~(format.gmask << 1)) | (format.bmask & ~(format.bmask << 1));
+		shift_mask = ~shift_mask;
 		switch (format.bpp) {
 		case 16:
 			PLATFORM_MapRGB(palette.bpp16[0], even_pal, 256);
 			PLATFORM_MapRGB(palette.bpp16[1], odd_pal, 256);
-			shift_mask |= shift_mask << 16;
+			FillBlendTable16(palette.bpp16, shift_mask & 0xffff);
 			break;
 		case 32:
 			PLATFORM_MapRGB(palette.bpp32[0], even_pal, 256);
 			PLATFORM_MapRGB(palette.bpp32[1], odd_pal, 256);
+			FillBlendTable32(palette.bpp32, shift_mask);
 		}
-		shift_mask = ~shift_mask;
 	}
 }
 
+/* Blends one scanline SRC with the previous scanline SRC_PREV into LINE. */
+static void BlendLine16(UWORD *line, UBYTE const *src, UBYTE const *src_prev, int width, int odd)
+{
+	UWORD const *table = blend.bpp16[odd];
+	int pos;
+	for (pos = 0; pos < width; ++pos)
+		line[pos] = table[BLEND_INDEX(src_prev[pos], src[pos])];
+}
+
+static void BlendLine32(ULONG *line, UBYTE const *src, UBYTE const *src_prev, int width, int odd)
+{
+	ULONG const *table = blend.bpp32[odd];
+	int pos;
+	for (pos = 0; pos < width; ++pos)
+		line[pos] = table[BLEND_INDEX(src_prev[pos], src[pos])];
+}
+
 void PAL_BLENDING_Blit16(ULONG *dest, UBYTE *src, int pitch, int width, int height, int start_odd)
 {
-	register ULONG quad, quad_prev;
-	register UBYTE c;
-	register int pos;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
-	int width_32;
-	if (width & 0x01)
-		width_32 = width + 1;
-	else
-		width_32 = width;
+	int width_32 = (width + 1) >> 1;
 	while (height > 0) {
-		pos = width_32;
-		do {
-			pos--;
-			c = src[pos];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp16[odd_prev][(src_prev[pos] & 0xf0) | (c & 0x0f)] << 16;
-			quad = palette.bpp16[start_odd][c] << 16;
-			pos--;
-			c = src[pos];
-			quad_prev |= palette.bpp16[odd_prev][(src_prev[pos] & 0xf0) | (c & 0x0f)];
-			quad |= palette.bpp16[start_odd][c];
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos >> 1] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos >> 1] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-		} while (pos > 0);
+		UWORD const *table = blend.bpp16[start_odd];
+		int pos;
+		for (pos = 0; pos < width_32; ++pos)
+			dest[pos] = table[BLEND_INDEX(src_prev[2*pos], src[2*pos])]
+			            | (table[BLEND_INDEX(src_prev[2*pos + 1], src[2*pos + 1])] << 16);
 		src_prev = src;
 		src += Screen_WIDTH;
 		dest += pitch;
 		height--;
 		start_odd ^= 1;
-		odd_prev ^= 1;
 	}
 }
 
 void PAL_BLENDING_Blit32(ULONG *dest, UBYTE *src, int pitch, int width, int height, int start_odd)
 {
-	register ULONG quad, quad_prev;
-	register UBYTE c;
-	register int pos;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
 	while (height > 0) {
-		pos = width;
-		do {
-			pos--;
-			c = src[pos];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp32[odd_prev][(src_prev[pos] & 0xf0) | (c & 0x0f)];
-			quad = palette.bpp32[start_odd][c];
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-		} while (pos > 0);
+		BlendLine32(dest, src, src_prev, width, start_odd);
 		src_prev = src;
 		src += Screen_WIDTH;
 		dest += pitch;
 		height--;
 		start_odd ^= 1;
-		odd_prev ^= 1;
 	}
 }
 
+/* The scaled blitters blend each source line only once, into a line buffer,
+   and copy the already scaled output line when a source line spans several
+   destination lines. */
 void PAL_BLENDING_BlitScaled16(ULONG *dest, UBYTE *src, int pitch, int width, int height, int dest_width, int dest_height, int start_odd)
 {
-	register ULONG quad, quad_prev;
+	UWORD line[Screen_WIDTH];
 	register int x;
 	int y = 0x10000;
 	int w1 = dest_width / 2 - 1;
@@ -180,29 +219,24 @@ void PAL_BLENDING_BlitScaled16(ULONG *dest, UBYTE *src, int pitch, int width, in
 	int dy = h / dest_height;
 	int init_x = (width << 16) - 0x4000;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
-
-	UBYTE c;
+	ULONG *dest_prev = NULL;
 
 	while (dest_height > 0) {
-		x = init_x;
-		pos = w1;
-		while (pos >= 0) {
-			c = src[x >> 16];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp16[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)] << 16;
-			quad = palette.bpp16[start_odd][c] << 16;
-			x -= dx;
-			c = src[x >> 16];
-			quad_prev |= palette.bpp16[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)];
-			quad |= palette.bpp16[start_odd][c];
-			x -= dx;
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-			pos--;
+		if (dest_prev != NULL)
+			memcpy(dest, dest_prev, (w1 + 1) * sizeof(ULONG));
+		else {
+			BlendLine16(line, src, src_prev, width, start_odd);
+			x = init_x;
+			pos = w1;
+			while (pos >= 0) {
+				register ULONG quad = line[x >> 16] << 16;
+				x -= dx;
+				quad |= line[x >> 16];
+				x -= dx;
+				dest[pos] = quad;
+				pos--;
+			}
+			dest_prev = dest;
 		}
 		dest += pitch;
 		y -= dy;
@@ -212,14 +246,14 @@ void PAL_BLENDING_BlitScaled16(ULONG *dest, UBYTE *src, int pitch, int width, in
 			src_prev = src;
 			src += Screen_WIDTH;
 			start_odd ^= 1;
-			odd_prev ^= 1;
+			dest_prev = NULL;
 		}
 	}
 }
 
 void PAL_BLENDING_BlitScaled32(ULONG *dest, UBYTE *src, int pitch, int width, int height, int dest_width, int dest_height, int start_odd)
 {
-	register ULONG quad, quad_prev;
+	ULONG line[Screen_WIDTH];
 	register int x;
 	int y = 0x10000;
 	int w1 = dest_width - 1;
@@ -230,25 +264,24 @@ void PAL_BLENDING_BlitScaled32(ULONG *dest, UBYTE *src, int pitch, int width, in
 	int dy = h / dest_height;
 	int init_x = w - 0x4000;
 	UBYTE *src_prev = src;
-	int odd_prev = start_odd ^ 1;
-
-	UBYTE c;
+	ULONG *dest_prev = NULL;
 
 	while (dest_height > 0) {
-		x = init_x;
-		pos = w1;
-		while (pos >= 0) {
-			c = src[x >> 16];
-			/* Make QUAD_PREV have the same Y component as the current line's pixel. */
-			quad_prev = palette.bpp32[odd_prev][(src_prev[x >> 16] & 0xf0) | (c & 0x0f)];
-			quad = palette.bpp32[start_odd][c];
-			x -= dx;
-			/* Since QUAD_PREV and QUAD have the same Y component, computing
-			   averages of even U/V and odd U/V is equal to computing averages
-			   of even and odd RGB components. */
-			/* dest[pos] = ((quad+quad_prev) & shift_mask)/2; */
-			dest[pos] = (quad & quad_prev) + (((quad ^ quad_prev) & shift_mask) >> 1);
-			pos--;
+		if (dest_prev != NULL)
+			memcpy(dest, dest_prev, dest_width * sizeof(ULONG));
+		else if (dx == 0x10000)
+			/* No horizontal scaling - blend straight into the destination. */
+			BlendLine32(dest_prev = dest, src, src_prev, width, start_odd);
+		else {
+			BlendLine32(line, src, src_prev, width, start_odd);
+			x = init_x;
+			pos = w1;
+			while (pos >= 0) {
+				dest[pos] = line[x >> 16];
+				x -= dx;
+				pos--;
+			}
+			dest_prev = dest;
 		}
 		dest += pitch;
 		y -= dy;
@@ -258,7 +291,7 @@ void PAL_BLENDING_BlitScaled32(ULONG *dest, UBYTE *src, int pitch, int width, in
 			src_prev = src;
 			src += Screen_WIDTH;
 			start_odd ^= 1;
-			odd_prev ^= 1;
+			dest_prev = NULL;
 		}
 	}
 }
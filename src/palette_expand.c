@@ -0,0 +1,270 @@
+/*
+ * palette_expand.c - conversion of palettised screen data to RGB pixels
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+
+ * You should have received a copy of the GNU General Public License along
+ * with Atari800; if not, write to the Free Software Foundation, Inc.,
+ * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
+ */
+
+#include <string.h>
+
+#include "palette_expand.h"
+
+void PALETTE_EXPAND_Line16(UWORD *dest, UBYTE const *src, int width, UWORD const *palette16)
+{
+	while (width >= 4) {
+		dest[0] = palette16[src[0]];
+		dest[1] = palette16[src[1]];
+		dest[2] = palette16[src[2]];
+		dest[3] = palette16[src[3]];
+		dest += 4;
+		src += 4;
+		width -= 4;
+	}
+	while (width > 0) {
+		*dest++ = palette16[*src++];
+		width--;
+	}
+}
+
+void PALETTE_EXPAND_Line32(ULONG *dest, UBYTE const *src, int width, ULONG const *palette32)
+{
+	while (width >= 4) {
+		dest[0] = palette32[src[0]];
+		dest[1] = palette32[src[1]];
+		dest[2] = palette32[src[2]];
+		dest[3] = palette32[src[3]];
+		dest += 4;
+		src += 4;
+		width -= 4;
+	}
+	while (width > 0) {
+		*dest++ = palette32[*src++];
+		width--;
+	}
+}
+
+void PALETTE_EXPAND_LineRGB24(UBYTE *dest, UBYTE const *src, UBYTE const *src2, int width, int const *palette)
+{
+	if (src2 == NULL) {
+		while (width > 0) {
+			int rgb = palette[*src++];
+			*dest++ = (UBYTE) (rgb >> 16);
+			*dest++ = (UBYTE) (rgb >> 8);
+			*dest++ = (UBYTE) rgb;
+			width--;
+		}
+	}
+	else {
+		while (width > 0) {
+			int rgb = palette[*src++];
+			int rgb2 = palette[*src2++];
+			*dest++ = (UBYTE) ((((rgb >> 16) & 0xff) + ((rgb2 >> 16) & 0xff)) >> 1);
+			*dest++ = (UBYTE) ((((rgb >> 8) & 0xff) + ((rgb2 >> 8) & 0xff)) >> 1);
+			*dest++ = (UBYTE) (((rgb & 0xff) + (rgb2 & 0xff)) >> 1);
+			width--;
+		}
+	}
+}
+
+/* Horizontal enlargement by 2 and 3. */
+static void Line16x2(UWORD *dest, UBYTE const *src, int width, UWORD const *palette16)
+{
+	while (width > 0) {
+		UWORD c = palette16[*src++];
+		dest[0] = c;
+		dest[1] = c;
+		dest += 2;
+		width--;
+	}
+}
+
+static void Line16x3(UWORD *dest, UBYTE const *src, int width, UWORD const *palette16)
+{
+	while (width > 0) {
+		UWORD c = palette16[*src++];
+		dest[0] = c;
+		dest[1] = c;
+		dest[2] = c;
+		dest += 3;
+		width--;
+	}
+}
+
+static void Line32x2(ULONG *dest, UBYTE const *src, int width, ULONG const *palette32)
+{
+	while (width > 0) {
+		ULONG c = palette32[*src++];
+		dest[0] = c;
+		dest[1] = c;
+		dest += 2;
+		width--;
+	}
+}
+
+static void Line32x3(ULONG *dest, UBYTE const *src, int width, ULONG const *palette32)
+{
+	while (width > 0) {
+		ULONG c = palette32[*src++];
+		dest[0] = c;
+		dest[1] = c;
+		dest[2] = c;
+		dest += 3;
+		width--;
+	}
+}
+
+/* Line converters, indexed by SCALE - 1. */
+static void (*const line16_funcs[3])(UWORD *, UBYTE const *, int, UWORD const *) = {
+	&PALETTE_EXPAND_Line16, &Line16x2, &Line16x3
+};
+static void (*const line32_funcs[3])(ULONG *, UBYTE const *, int, ULONG const *) = {
+	&PALETTE_EXPAND_Line32, &Line32x2, &Line32x3
+};
+
+/* Copies WIDTH pixels from SRC to DEST, scaling each colour component by
+   FACTOR/32 (16-bit) or FACTOR/256 (32-bit). If SRC2 is not NULL, the sum
+   of the pixels from SRC and SRC2 is scaled instead. The arithmetic is the
+   same as in scanLines_16()/scanLines_32() in sdl/video_sw.c. */
+static void Darken16(UWORD *dest, UWORD const *src, UWORD const *src2, int width, ULONG factor)
+{
+	if (src2 == NULL) {
+		while (width > 0) {
+			ULONG pixel = *src++;
+			*dest++ = (UWORD) ((((pixel & 0xf81f) * factor >> 5) & 0xf81f)
+			                   | (((pixel & 0x07e0) * factor >> 5) & 0x07e0));
+			width--;
+		}
+	}
+	else {
+		while (width > 0) {
+			ULONG pixel = *src++;
+			ULONG pixel2 = *src2++;
+			*dest++ = (UWORD) (((((pixel & 0xf81f) + (pixel2 & 0xf81f)) * factor >> 5) & 0xf81f)
+			                   | ((((pixel & 0x07e0) + (pixel2 & 0x07e0)) * factor >> 5) & 0x07e0));
+			width--;
+		}
+	}
+}
+
+static void Darken32(ULONG *dest, ULONG const *src, ULONG const *src2, int width, ULONG factor)
+{
+	if (src2 == NULL) {
+		while (width > 0) {
+			ULONG pixel = *src++;
+			ULONG a = (((pixel & 0x00ff00ff) * factor) & 0xff00ff00) >> 8;
+			ULONG b = (((pixel & 0x0000ff00) >> 8) * factor) & 0x0000ff00;
+			*dest++ = a | b;
+			width--;
+		}
+	}
+	else {
+		while (width > 0) {
+			ULONG pixel = *src++;
+			ULONG pixel2 = *src2++;
+			ULONG a = ((((pixel & 0x00ff00ff) + (pixel2 & 0x00ff00ff)) * factor) & 0xff00ff00) >> 8;
+			ULONG b = ((((pixel & 0x0000ff00) + (pixel2 & 0x0000ff00)) >> 8) * factor) & 0x0000ff00;
+			*dest++ = a | b;
+			width--;
+		}
+	}
+}
+
+/* Fills lines 1 .. SCALE-1 of an enlarged row from its line 0, at LINE0.
+   NEXT is line 0 of the following row, or NULL for the last row. Like
+   scanLines_16()/scanLines_32(), the last line of the row is darkened by
+   SCANLINES_PCT percent, or is the darkened average of LINE0 and NEXT if
+   INTERPOLATE. At 3x, the middle line is darkened by half as much, so that
+   scanlines cover half of the row as they do at 2x. */
+static void FillRow16(UBYTE *line0, int dest_pitch, int width, int scale, UBYTE const *next, int scanlines_pct, int interpolate)
+{
+	UBYTE *last = line0 + (scale - 1) * dest_pitch;
+	if (scanlines_pct == 0) {
+		int i;
+		for (i = 1; i < scale; i++)
+			memcpy(line0 + i * dest_pitch, line0, width * sizeof(UWORD));
+		return;
+	}
+	if (scale == 3)
+		Darken16((UWORD *) (line0 + dest_pitch), (UWORD const *) line0, NULL, width, (200 - scanlines_pct) * 32 / 200);
+	if (interpolate && next != NULL)
+		Darken16((UWORD *) last, (UWORD const *) line0, (UWORD const *) next, width, (100 - scanlines_pct) * 32 / 200);
+	else
+		Darken16((UWORD *) last, (UWORD const *) line0, NULL, width, (100 - scanlines_pct) * 32 / 100);
+}
+
+static void FillRow32(UBYTE *line0, int dest_pitch, int width, int scale, UBYTE const *next, int scanlines_pct, int interpolate)
+{
+	UBYTE *last = line0 + (scale - 1) * dest_pitch;
+	if (scanlines_pct == 0) {
+		int i;
+		for (i = 1; i < scale; i++)
+			memcpy(line0 + i * dest_pitch, line0, width * sizeof(ULONG));
+		return;
+	}
+	if (scale == 3)
+		Darken32((ULONG *) (line0 + dest_pitch), (ULONG const *) line0, NULL, width, (200 - scanlines_pct) * 256 / 200);
+	if (interpolate && next != NULL)
+		Darken32((ULONG *) last, (ULONG const *) line0, (ULONG const *) next, width, (100 - scanlines_pct) * 256 / 200);
+	else
+		Darken32((ULONG *) last, (ULONG const *) line0, NULL, width, (100 - scanlines_pct) * 256 / 100);
+}
+
+/* Line 0 of each row is converted one row ahead, because interpolated
+   scanlines need line 0 of the following row. */
+void PALETTE_EXPAND_Blit16(void *dest, int dest_pitch, UBYTE const *src, int src_pitch, int width, int height, int scale, int scanlines_pct, int interpolate, UWORD const *palette16)
+{
+	void (*line_func)(UWORD *, UBYTE const *, int, UWORD const *) = line16_funcs[scale - 1];
+	UBYTE *dest_line = (UBYTE *) dest;
+	if (height <= 0)
+		return;
+	(*line_func)((UWORD *) dest_line, src, width, palette16);
+	while (height > 0) {
+		UBYTE *next = NULL;
+		if (height > 1) {
+			next = dest_line + scale * dest_pitch;
+			(*line_func)((UWORD *) next, src + src_pitch, width, palette16);
+		}
+		if (scale > 1)
+			FillRow16(dest_line, dest_pitch, width * scale, scale, next, scanlines_pct, interpolate);
+		src += src_pitch;
+		dest_line += scale * dest_pitch;
+		height--;
+	}
+}
+
+void PALETTE_EXPAND_Blit32(void *dest, int dest_pitch, UBYTE const *src, int src_pitch, int width, int height, int scale, int scanlines_pct, int interpolate, ULONG const *palette32)
+{
+	void (*line_func)(ULONG *, UBYTE const *, int, ULONG const *) = line32_funcs[scale - 1];
+	UBYTE *dest_line = (UBYTE *) dest;
+	if (height <= 0)
+		return;
+	(*line_func)((ULONG *) dest_line, src, width, palette32);
+	while (height > 0) {
+		UBYTE *next = NULL;
+		if (height > 1) {
+			next = dest_line + scale * dest_pitch;
+			(*line_func)((ULONG *) next, src + src_pitch, width, palette32);
+		}
+		if (scale > 1)
+			FillRow32(dest_line, dest_pitch, width * scale, scale, next, scanlines_pct, interpolate);
+		src += src_pitch;
+		dest_line += scale * dest_pitch;
+		height--;
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef PALETTE_EXPAND_H_
+#define PALETTE_EXPAND_H_
+
+#include "atari.h"
+
+/* Conversion of 8-bit palette indices, as stored in Screen_atari, to 16-,
+   24- or 32-bit pixels. Shared by the software blitters and the screenshot
+   codecs. */
+
+/* Converts WIDTH pixels from SRC to DEST through PALETTE16/PALETTE32. */
+void PALETTE_EXPAND_Line16(UWORD *dest, UBYTE const *src, int width, UWORD const *palette16);
+void PALETTE_EXPAND_Line32(ULONG *dest, UBYTE const *src, int width, ULONG const *palette32);
+
+/* Converts WIDTH pixels from SRC to R, G, B byte triplets in DEST, using
+   PALETTE with 0xRRGGBB entries (eg. Colours_table). If SRC2 is not NULL,
+   each output pixel is the average of colours from SRC and SRC2 (used for
+   interlaced screenshots). */
+void PALETTE_EXPAND_LineRGB24(UBYTE *dest, UBYTE const *src, UBYTE const *src2, int width, int const *palette);
+
+/* Converts a WIDTH x HEIGHT area of SRC to DEST, enlarging each pixel SCALE
+   times (1, 2 or 3) in both directions. SRC_PITCH and DEST_PITCH are line
+   lengths in bytes. When SCALE > 1 and SCANLINES_PCT > 0, scanlines are
+   drawn as by scanLines_16()/scanLines_32() in sdl/video_sw.c: the last line
+   of every enlarged row is darkened by SCANLINES_PCT percent (at 3x the
+   middle line by half as much), and if INTERPOLATE is nonzero the darkened
+   line is blended with the following row. Darkening assumes R5G6B5 pixels
+   in Blit16 and X8R8G8B8 pixels in Blit32. */
+void PALETTE_EXPAND_Blit16(void *dest, int dest_pitch, UBYTE const *src, int src_pitch, int width, int height, int scale, int scanlines_pct, int interpolate, UWORD const *palette16);
+void PALETTE_EXPAND_Blit32(void *dest, int dest_pitch, UBYTE const *src, int src_pitch, int width, int height, int scale, int scanlines_pct, int interpolate, ULONG const *palette32);
+
+#endif /* PALETTE_EXPAND_H_ */
@@ -79,10 +79,9 @@ static void init_bb(void)
 	}
 	D(printf("loaded black box rom image\n"));
 	PBI_BB_enabled = TRUE;
-	if (PBI_SCSI_disk != NULL) fclose(PBI_SCSI_disk);
+	PBI_SCSI_Close();
 	if (!Util_filenamenotset(bb_scsi_disk_filename)) {
-		PBI_SCSI_disk = fopen(bb_scsi_disk_filename, "rb+");
-		if (PBI_SCSI_disk == NULL) {
+		if (!PBI_SCSI_Open(bb_scsi_disk_filename)) {
 			Log_print("Error opening BB SCSI disk image:%s", bb_scsi_disk_filename);
 		}
 		else {
@@ -119,10 +118,7 @@ int PBI_BB_Initialise(int *argc, char *argv[])
 
 void PBI_BB_Exit(void)
 {
-	if (PBI_SCSI_disk != NULL) {
-		fclose(PBI_SCSI_disk);
-		PBI_SCSI_disk = NULL;
-	}
+	PBI_SCSI_Close();
 	free(bb_ram);
 	free(bb_rom);
 	bb_rom = bb_ram = NULL;
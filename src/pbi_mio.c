@@ -64,10 +64,9 @@ static void init_mio(void)
 	}
 	D(printf("Loaded mio rom image\n"));
 	PBI_MIO_enabled = TRUE;
-	if (PBI_SCSI_disk != NULL) fclose(PBI_SCSI_disk);
+	PBI_SCSI_Close();
 	if (!Util_filenamenotset(mio_scsi_disk_filename)) {
-		PBI_SCSI_disk = fopen(mio_scsi_disk_filename, "rb+");
-		if (PBI_SCSI_disk == NULL) {
+		if (!PBI_SCSI_Open(mio_scsi_disk_filename)) {
 			Log_print("Error opening SCSI disk image:%s", mio_scsi_disk_filename);
 		}
 		else {
@@ -104,10 +103,7 @@ int PBI_MIO_Initialise(int *argc, char *argv[])
 
 void PBI_MIO_Exit(void)
 {
-	if (PBI_SCSI_disk != NULL) {
-		fclose(PBI_SCSI_disk);
-		PBI_SCSI_disk = NULL;
-	}
+	PBI_SCSI_Close();
 	free(mio_ram);
 	free(mio_rom);
 	mio_rom = mio_ram = NULL;
@@ -23,6 +23,7 @@
 */
 
 #include "atari.h"
+#include "diskcache.h"
 #include "util.h"
 #include "log.h"
 #include "pbi_scsi.h"
@@ -51,12 +52,36 @@ static UBYTE scsi_byte;
 #define SCSI_PHASE_STATUS 4 
 #define SCSI_PHASE_MSGIN 5
 
+#define SCSI_STATUS_GOOD 0x00
+#define SCSI_STATUS_CHECK_CONDITION 0x02
+
 static int scsi_phase = SCSI_PHASE_SELECTION;
 static int scsi_bufpos = 0;
 static UBYTE scsi_buffer[256];
 static int scsi_count = 0;
+static int scsi_lba;
 
-FILE *PBI_SCSI_disk = NULL;
+static FILE *disk = NULL;
+static DISKCACHE_t *disk_cache = NULL;
+
+int PBI_SCSI_Open(const char *filename)
+{
+	PBI_SCSI_Close();
+	disk = fopen(filename, "rb+");
+	if (disk == NULL)
+		return FALSE;
+	disk_cache = DISKCACHE_New(disk);
+	return TRUE;
+}
+
+void PBI_SCSI_Close(void)
+{
+	if (disk != NULL) {
+		DISKCACHE_Free(disk_cache);
+		fclose(disk);
+		disk = NULL;
+	}
+}
 
 static void scsi_changephase(int phase)
 {
@@ -138,8 +163,9 @@ static void scsi_process_command(void)
 /*			lun = ((scsi_buffer[1]&0xe0)>>5);*/
 			lba = (((scsi_buffer[1]&0x1f)<<16)|(scsi_buffer[2]<<8)|(scsi_buffer[3]));
 			D(printf("SCSI: read lun:%d lba:%d\n",lun,lba));
-			fseek(PBI_SCSI_disk, lba*256, SEEK_SET);
-			scsi_count = fread(scsi_buffer, 1, 256, PBI_SCSI_disk);
+			scsi_count = DISKCACHE_Read(disk_cache, (off_t) lba*256, scsi_buffer, 256);
+			if (scsi_count < 0)
+				scsi_count = 0;
 			scsi_changephase(SCSI_PHASE_DATAIN);
 			/* scsi_count = 256; */
 			break;
@@ -148,7 +174,7 @@ static void scsi_process_command(void)
 /*			lun = ((scsi_buffer[1]&0xe0)>>5);*/
 			lba = (((scsi_buffer[1]&0x1f)<<16)|(scsi_buffer[2]<<8)|(scsi_buffer[3]));
 			D(printf("SCSI: write lun:%d lba:%d\n",lun,lba));
-			fseek(PBI_SCSI_disk, lba*256, SEEK_SET);
+			scsi_lba = lba;
 			scsi_changephase(SCSI_PHASE_DATAOUT);
 			scsi_count = 256;
 			break;
@@ -188,9 +214,11 @@ static void scsi_nextbyte(void)
 		D(printf("SCSI data out:%2x\n", scsi_byte));
 		scsi_buffer[scsi_bufpos++] = scsi_byte;
 		if (scsi_bufpos >= scsi_count) {
-			fwrite(scsi_buffer, 1, 256, PBI_SCSI_disk);
+			int ok = DISKCACHE_Write(disk_cache, (off_t) scsi_lba*256, scsi_buffer, 256);
+			if (!ok)
+				Log_print("SCSI: error writing sector %d", scsi_lba);
 			scsi_changephase(SCSI_PHASE_STATUS);
-			scsi_buffer[0] = 0;
+			scsi_buffer[0] = ok ? SCSI_STATUS_GOOD : SCSI_STATUS_CHECK_CONDITION;
 		}
 	}
 }
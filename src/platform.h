@@ -44,6 +44,13 @@ void PLATFORM_ConfigSave(FILE *fp);
 void PLATFORM_PaletteUpdate(void);
 #endif
 
+#ifdef SUPPORTS_PLATFORM_DISPLAYCHANGE
+/* Called before the video mode parameters (VIDEOMODE_src_*,
+ * VIDEOMODE_dest_*) or the palette are recomputed, so that the platform
+ * can stop anything that reads them in the background */
+void PLATFORM_BeforeDisplayChange(void);
+#endif
+
 #ifdef SUPPORTS_PLATFORM_SLEEP
 /* This function is for those ports that need their own version of sleep */
 void PLATFORM_Sleep(double s);
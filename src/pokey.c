@@ -188,6 +188,9 @@ void POKEY_PutByte(UWORD addr, UBYTE byte)
 	addr &= POKEYSND_stereo_enabled ? 0x1f : 0x0f;
 #else
 	addr &= 0x0f;
+#endif
+#ifdef POKEYREC
+	POKEYREC_PutByte(addr, byte);
 #endif
 	switch (addr) {
 	case POKEY_OFFSET_AUDC1:
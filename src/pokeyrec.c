@@ -25,10 +25,15 @@
 #include "config.h"
 #include "pokeyrec.h"
 #include "pokey.h"
+#include "pokeysnd.h"
+#include "antic.h"
 #include "log.h"
 #include "util.h"
 #include <string.h>
 #include <stdio.h>
+#ifdef HAVE_LIBZ
+#include <zlib.h>
+#endif
 
 static int enabled, counter, interval;
 static char *filename = "pokeyrec.dat", *fmt = "%c";
@@ -37,6 +42,99 @@ static FILE *fp;
 static int stereo;
 #endif
 
+/* Binary log, see pokeyrec.h for the format. */
+static int binary, started;
+static unsigned int last_clock;
+static UBYTE outbuf[4096];
+static unsigned int outlen;
+#ifdef HAVE_LIBZ
+static int gzip_output;
+static gzFile gzfp;
+#endif
+
+static void flush_binary(void) {
+#ifdef HAVE_LIBZ
+    if (gzfp)
+        gzwrite(gzfp, outbuf, outlen);
+    else
+#endif
+    fwrite(outbuf, 1, outlen, fp);
+    outlen = 0;
+}
+
+static void put_record(unsigned int clock, int reg, UBYTE val) {
+    unsigned int delta = clock - last_clock;
+    last_clock = clock;
+    /* a record takes at most 5 + 2 bytes */
+    if (outlen > sizeof(outbuf) - 7)
+        flush_binary();
+    while (delta >= 0x80) {
+        outbuf[outlen++] = (UBYTE) (delta | 0x80);
+        delta >>= 7;
+    }
+    outbuf[outlen++] = (UBYTE) delta;
+    outbuf[outlen++] = (UBYTE) reg;
+    if (reg != POKEYREC_END)
+        outbuf[outlen++] = val;
+}
+
+/* Writes the header and the current sound registers. */
+static void start_binary(void) {
+    unsigned int clock = ANTIC_CPU_CLOCK;
+    int chips = 1;
+    int c, i;
+    memcpy(outbuf, POKEYREC_MAGIC, 8);
+    outbuf[8] = POKEYREC_VERSION;
+    outbuf[9] = 0;
+#ifdef STEREO_SOUND
+    if (POKEYSND_stereo_enabled) {
+        outbuf[9] |= POKEYREC_STEREO;
+        chips = 2;
+    }
+#endif
+    outbuf[10] = (UBYTE) Atari800_tv_mode;
+    outbuf[11] = (UBYTE) (Atari800_tv_mode >> 8);
+    outbuf[12] = (UBYTE) clock;
+    outbuf[13] = (UBYTE) (clock >> 8);
+    outbuf[14] = (UBYTE) (clock >> 16);
+    outbuf[15] = (UBYTE) (clock >> 24);
+    outlen = POKEYREC_HEADER_SIZE;
+    last_clock = clock;
+    for (c = 0; c < chips; c++) {
+        put_record(clock, (c << 4) | POKEY_OFFSET_AUDCTL, POKEY_AUDCTL[c]);
+        for (i = 0; i < 4; i++) {
+            put_record(clock, (c << 4) | (POKEY_OFFSET_AUDF1 + 2 * i), POKEY_AUDF[c * 4 + i]);
+            put_record(clock, (c << 4) | (POKEY_OFFSET_AUDC1 + 2 * i), POKEY_AUDC[c * 4 + i]);
+        }
+    }
+    put_record(clock, POKEY_OFFSET_SKCTL, POKEY_SKCTL);
+    started = 1;
+}
+
+void POKEYREC_PutByte(UWORD addr, UBYTE byte) {
+    if (!binary) return;
+
+    switch (addr & 0x0f) {
+    case POKEY_OFFSET_AUDF1:
+    case POKEY_OFFSET_AUDC1:
+    case POKEY_OFFSET_AUDF2:
+    case POKEY_OFFSET_AUDC2:
+    case POKEY_OFFSET_AUDF3:
+    case POKEY_OFFSET_AUDC3:
+    case POKEY_OFFSET_AUDF4:
+    case POKEY_OFFSET_AUDC4:
+    case POKEY_OFFSET_AUDCTL:
+    case POKEY_OFFSET_STIMER:
+    case POKEY_OFFSET_SKCTL:
+        if (!started)
+            start_binary();
+        put_record(ANTIC_CPU_CLOCK, addr & 0x1f, byte);
+        break;
+    default:
+        break;
+    }
+}
+
 static void output_pokey_values(int pokeynr) {
     int i;
     for (i=0; i<4; i++) {
@@ -47,7 +145,7 @@ static void output_pokey_values(int pokeynr) {
 }
 
 void POKEYREC_Recorder(void) {
-    if (!enabled) return;
+    if (!enabled || binary) return;
 
     if (++counter == interval) {
         counter = 0;
@@ -79,6 +177,12 @@ int POKEYREC_Initialise(int *argc, char *argv[]) {
             }
         } else if (!strcmp(argv[i], "-pokeyrec-ascii")) {
             fmt = "%02x";
+        } else if (!strcmp(argv[i], "-pokeyrec-binary")) {
+            binary = 1;
+#ifdef HAVE_LIBZ
+        } else if (!strcmp(argv[i], "-pokeyrec-compress")) {
+            binary = gzip_output = 1;
+#endif
         } else if (!strcmp(argv[i], "-pokeyrec-file")) {
             if (!available) goto missing_argument;
             filename = Util_strdup(argv[++i]);
@@ -95,6 +199,12 @@ int POKEYREC_Initialise(int *argc, char *argv[]) {
                                                                     interval);
                 Log_print("\t-pokeyrec-ascii            "
                                 "Store ascii values (default: raw)");
+                Log_print("\t-pokeyrec-binary           "
+                                "Log every register write with its cycle");
+#ifdef HAVE_LIBZ
+                Log_print("\t-pokeyrec-compress         "
+                                "Same as -pokeyrec-binary, gzip compressed");
+#endif
                 Log_print("\t-pokeyrec-file <filename>  "
                                 "Specify output filename "
                                                     "(default: pokeyrec.dat)");
@@ -110,7 +220,21 @@ int POKEYREC_Initialise(int *argc, char *argv[]) {
 
     *argc = j;
 
-    if (enabled) {
+    if (binary) {
+        enabled = 1;
+#ifdef HAVE_LIBZ
+        if (gzip_output) {
+            if (!(gzfp = gzopen(filename, "wb"))) {
+                Log_print("Unable to open '%s' for writing", filename);
+                return FALSE;
+            }
+        } else
+#endif
+        if (!(fp = fopen(filename, "wb"))) {
+            Log_print("Unable to open '%s' for writing", filename);
+            return FALSE;
+        }
+    } else if (enabled) {
         if (!(fp = fopen(filename, "wb"))) {
             Log_print("Unable to open '%s' for writing", filename);
             return FALSE;
@@ -125,5 +249,21 @@ missing_argument:
 }
 
 void POKEYREC_Exit(void) {
-    if (fp) fclose(fp);
+    if (binary && enabled) {
+        if (!started)
+            start_binary();
+        put_record(ANTIC_CPU_CLOCK, POKEYREC_END, 0);
+        flush_binary();
+        binary = 0;
+    }
+#ifdef HAVE_LIBZ
+    if (gzfp) {
+        gzclose(gzfp);
+        gzfp = NULL;
+    }
+#endif
+    if (fp) {
+        fclose(fp);
+        fp = NULL;
+    }
 }
@@ -1,7 +1,34 @@
 #ifndef POKEYREC_H_
 #define POKEYREC_H_
 
+#include "atari.h"
+
+/* Binary register log, written with -pokeyrec-binary or -pokeyrec-compress
+   (gzip). It starts with a POKEYREC_HEADER_SIZE-byte header:
+     8 bytes  POKEYREC_MAGIC
+     1 byte   POKEYREC_VERSION
+     1 byte   flags, POKEYREC_STEREO if the second POKEY is emulated
+     2 bytes  scanlines per frame (312 PAL, 262 NTSC), little endian
+     4 bytes  CPU cycle of the first record, counted from the start of
+              the emulation (modulo 2^32), little endian
+   followed by one record per write to a sound register:
+     the number of CPU cycles since the previous record, as an unsigned
+     LEB128 number (7 bits per byte, low bits first, bit 7 set in all but
+     the last byte),
+     1 byte   register (0x00-0x0f; 0x10-0x1f for the second POKEY),
+     1 byte   value written.
+   The first records hold the state of the registers when the log starts.
+   The log ends with a record whose register is POKEYREC_END and which has
+   no value byte. */
+#define POKEYREC_MAGIC "A8PKYLOG"
+#define POKEYREC_VERSION 1
+#define POKEYREC_STEREO 0x01
+#define POKEYREC_HEADER_SIZE 16
+#define POKEYREC_END 0xff
+
 void POKEYREC_Recorder(void);
+/* Called by POKEY_PutByte for every write to POKEY. */
+void POKEYREC_PutByte(UWORD addr, UBYTE byte);
 int  POKEYREC_Initialise(int *argc, char *argv[]);
 void POKEYREC_Exit(void);
 
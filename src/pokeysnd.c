@@ -25,6 +25,7 @@
 #include "config.h"
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 
 #ifdef ASAP /* external project, see http://asap.sf.net */
 #include "asap_internal.h"
@@ -44,6 +45,9 @@
 #include "antic.h"
 #include "gtia.h"
 #include "util.h"
+#ifdef SOUND_THREADS
+#include "sndworker.h"
+#endif
 
 #ifdef WORDS_UNALIGNED_OK
 #  define READ_U32(x)     (*(ULONG *) (x))
@@ -117,6 +121,20 @@ static ULONG Div_n_cnt[4 * POKEY_MAXPOKEYS],		/* Divide by n counter. one for ea
 static ULONG Samp_n_max,		/* Sample max.  For accuracy, it is *256 */
  Samp_n_cnt[2];					/* Sample cnt. */
 
+/* the sample counter's low word, which holds the 8 fractional bits */
+#ifdef WORDS_BIGENDIAN
+#define SAMP_N_CNT_LOW Samp_n_cnt[1]
+#else
+#define SAMP_N_CNT_LOW Samp_n_cnt[0]
+#endif
+
+/* Number of further samples that will repeat the last generated one,
+   as computed by pokeysnd_process_8(). Cleared on every register update. */
+static int steady_samples = 0;
+
+/* Number of samples that were copied instead of being synthesised. */
+unsigned long POKEYSND_fast_samples = 0;
+
 #ifdef INTERPOLATE_SOUND
 #ifdef CLIP_SOUND
 static SWORD last_val = 0;		/* last output value */
@@ -355,12 +373,31 @@ void POKEYSND_SetMzQuality(int quality)	/* specially for win32, perhaps not need
 	mz_quality = quality;
 }
 
+#if defined(SOUND_THREADS) && (defined(PBI_XLD) || defined (VOICEBOX))
+static void VotraxJob(void *arg)
+{
+	VOTRAXSND_Generate(*(int *) arg);
+}
+#endif
+
 void POKEYSND_Process(void *sndbuffer, int sndn)
 {
+#if defined(SOUND_THREADS) && (defined(PBI_XLD) || defined (VOICEBOX))
+	if (VOTRAXSND_Enabled()) {
+		/* Synthesise the voice on a worker thread meanwhile. */
+		int job = SNDWORKER_Start(&VotraxJob, &sndn);
+		POKEYSND_Process_ptr(sndbuffer, sndn);
+		SNDWORKER_Wait(job);
+		VOTRAXSND_Mix(sndbuffer);
+	}
+	else
+		POKEYSND_Process_ptr(sndbuffer, sndn);
+#else
 	POKEYSND_Process_ptr(sndbuffer, sndn);
 #if defined(PBI_XLD) || defined (VOICEBOX)
 	VOTRAXSND_Process(sndbuffer,sndn);
 #endif
+#endif
 #if !defined(__PLUS) && !defined(ASAP)
 	File_Export_WriteAudio((const unsigned char *)sndbuffer, sndn);
 #endif
@@ -435,6 +472,7 @@ static int pokeysnd_init_rf(ULONG freq17, int playback_freq,
 
 	Samp_n_cnt[0] = 0;			/* initialize all bits of the sample */
 	Samp_n_cnt[1] = 0;			/* 'divide by N' counter */
+	steady_samples = 0;
 
 	for (chan = 0; chan < (POKEY_MAXPOKEYS * 4); chan++) {
 		Outvol[chan] = 0;
@@ -492,6 +530,8 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 	UBYTE chan_mask;
 	UBYTE chip_offs;
 
+	steady_samples = 0;
+
 	/* calculate the chip_offs for the channel arrays */
 	chip_offs = chip << 2;
 
@@ -746,6 +786,26 @@ static void Update_pokey_sound_rf(UWORD addr, UBYTE val, UBYTE chip,
 /*                                                                           */
 /*****************************************************************************/
 
+/* Returns the number of samples pokeysnd_process_8() will generate before
+   the next channel event, given the whole and fractional parts of the
+   sample counter. */
+static int samples_to_next_event(ULONG samp_whole, ULONG samp_frac)
+{
+	ULONG div_min = Div_n_cnt[0];
+	double span;
+	int chan;
+
+	for (chan = 1; chan < 4 * Num_pokeys; chan++) {
+		if (Div_n_cnt[chan] < div_min)
+			div_min = Div_n_cnt[chan];
+	}
+	/* a channel event wins a tie with the sample counter */
+	if (div_min <= samp_whole)
+		return 0;
+	span = ceil(((double) div_min * 256 - ((double) samp_whole * 256 + samp_frac)) / Samp_n_max);
+	return span > 0x7fffffff ? 0x7fffffff : (int) span;
+}
+
 static void pokeysnd_process_8(void *sndbuffer, int sndn)
 {
 	register UBYTE *buffer = (UBYTE *) sndbuffer;
@@ -1048,6 +1108,7 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 			/* adjust the sample counter - note we're using the 24.8 integer
 			   which includes an 8 bit fraction for accuracy */
 
+			UBYTE *sample_start = buffer;
 			int iout;
 #ifdef STEREO_SOUND
 			int iout2;
@@ -1211,6 +1272,45 @@ static void pokeysnd_process_8(void *sndbuffer, int sndn)
 			if (Num_pokeys > 1)
 				n--;
 #endif
+
+#ifndef __PLUS
+			/* Until the next channel event the output can only change
+			   through interpolation or volume-only samples. If neither is
+			   pending, repeat the sample just written instead of looping. */
+			if (
+#ifdef INTERPOLATE_SOUND
+				cur_val == last_val &&
+#ifdef STEREO_SOUND
+				cur_val2 == last_val2 &&
+#endif
+#endif /* INTERPOLATE_SOUND */
+#ifdef VOL_ONLY_SOUND
+				POKEYSND_sampbuf_rptr == POKEYSND_sampbuf_ptr &&
+#ifdef STEREO_SOUND
+				sampbuf_rptr2 == sampbuf_ptr2 &&
+#endif
+#endif /* VOL_ONLY_SOUND */
+				TRUE) {
+				int size = buffer - sample_start;
+				int repeat = samples_to_next_event(READ_U32(samp_cnt_w_ptr), SAMP_N_CNT_LOW & 0xff);
+				steady_samples = repeat;
+				if (repeat > n / size)
+					repeat = n / size;
+				if (repeat > 0) {
+					int i;
+					for (i = 0; i < repeat; i++) {
+						memcpy(buffer, sample_start, size);
+						buffer += size;
+					}
+					SAMP_N_CNT_LOW += repeat * Samp_n_max;
+					n -= repeat * size;
+					steady_samples -= repeat;
+					POKEYSND_fast_samples += repeat;
+				}
+			}
+			else
+				steady_samples = 0;
+#endif /* __PLUS */
 		}
 	}
 #ifdef VOL_ONLY_SOUND
@@ -1240,6 +1340,7 @@ static void Update_serio_sound_rf(int out, UBYTE data)
 #endif
 	int bits, pv, future;
 	if (!POKEYSND_serio_sound_enabled) return;
+	steady_samples = 0;
 
 	pv = 0;
 	future = 0;
@@ -1282,6 +1383,7 @@ void POKEYSND_SetVolume(int vol)
         vol = 0;
 
     POKEYSND_volume = vol * 0x100 / 100;
+    steady_samples = 0;
 }
 
 static void pokeysnd_process_16(void *sndbuffer, int sndn)
@@ -1329,7 +1431,22 @@ static void Generate_sync_rf(unsigned int num_ticks)
 		samp_pos = new_samp_pos;
 		num_ticks -= ticks;
 
-		if (POKEYSND_snd_flags & POKEYSND_BIT16) {
+		if (steady_samples > 0 && buffer > POKEYSND_process_buffer) {
+			/* the output can't change before the next channel event */
+			int size = (POKEYSND_snd_flags & POKEYSND_BIT16) ? 2 * POKEYSND_num_pokeys : POKEYSND_num_pokeys;
+			memcpy(buffer, buffer - size, size);
+			buffer += size;
+			SAMP_N_CNT_LOW += Samp_n_max;
+#ifdef VOL_ONLY_SOUND
+			POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+#ifdef STEREO_SOUND
+			sampbuf_last2 = ANTIC_CPU_CLOCK;
+#endif
+#endif /* VOL_ONLY_SOUND */
+			steady_samples--;
+			POKEYSND_fast_samples++;
+		}
+		else if (POKEYSND_snd_flags & POKEYSND_BIT16) {
 			pokeysnd_process_16(buffer, POKEYSND_num_pokeys);
 			buffer += 2 * POKEYSND_num_pokeys;
 		}
@@ -1358,6 +1475,7 @@ void POKEYSND_UpdateConsol(int set)
 
 static void Update_consol_sound_rf(int set)
 {
+	steady_samples = 0;
 #ifdef SYNCHRONIZED_SOUND
 	if (set)
 		speaker = CONSOLE_VOL * GTIA_speaker;
@@ -1416,3 +1534,21 @@ static void Update_vol_only_sound_rf(void)
 #endif /* CONSOLE_SOUND */
 }
 #endif  /* VOL_ONLY_SOUND */
+
+#ifdef VOL_ONLY_SOUND
+void POKEYSND_DiscardVolOnly(void)
+{
+	if (POKEYSND_sampbuf_rptr != POKEYSND_sampbuf_ptr) {
+		POKEYSND_sampout = POKEYSND_sampbuf_val[(POKEYSND_sampbuf_ptr + POKEYSND_SAMPBUF_MAX - 1) % POKEYSND_SAMPBUF_MAX];
+		POKEYSND_sampbuf_rptr = POKEYSND_sampbuf_ptr;
+	}
+	POKEYSND_sampbuf_last = ANTIC_CPU_CLOCK;
+#ifdef STEREO_SOUND
+	if (sampbuf_rptr2 != sampbuf_ptr2) {
+		sampout2 = sampbuf_val2[(sampbuf_ptr2 + POKEYSND_SAMPBUF_MAX - 1) % POKEYSND_SAMPBUF_MAX];
+		sampbuf_rptr2 = sampbuf_ptr2;
+	}
+	sampbuf_last2 = ANTIC_CPU_CLOCK;
+#endif /* STEREO_SOUND */
+}
+#endif  /* VOL_ONLY_SOUND */
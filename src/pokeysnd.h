@@ -90,6 +90,10 @@ extern int POKEYSND_serio_sound_enabled;
 extern int POKEYSND_console_sound_enabled;
 extern int POKEYSND_bienias_fix;
 
+/* Number of output samples produced by copying a constant span of output
+   instead of running the synthesis loop. Statistics only. */
+extern unsigned long POKEYSND_fast_samples;
+
 extern void (*POKEYSND_Process_ptr)(void *sndbuffer, int sndn);
 extern void (*POKEYSND_Update_ptr)(UWORD addr, UBYTE val, UBYTE chip, UBYTE gain);
 extern void (*POKEYSND_UpdateSerio)(int out, UBYTE data);
@@ -127,6 +131,11 @@ extern int	POKEYSND_sampbuf_lastval;		/* last volume */
 extern int	POKEYSND_sampout;			/* last out volume */
 extern int	POKEYSND_samp_freq;
 extern int	POKEYSND_samp_consol_val;		/* actual value of console sound */
+
+/* Drops the volume-only samples not yet mixed into the output, as if sound
+   had been generated up to the current CPU clock. Used when the output for
+   a period of emulation is not needed. */
+void POKEYSND_DiscardVolOnly(void);
 #endif  /* VOL_ONLY_SOUND */
 
 #ifdef SYNCHRONIZED_SOUND
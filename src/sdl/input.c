@@ -1555,6 +1555,8 @@ static int Keyboard_AtariKeys(void)
 				return AKEY_NONE;
 			default:
 				if(FILTER_NTSC_emu != NULL){
+					/* The filter tables are about to change. */
+					SDL_VIDEO_StopDisplayThread();
 					switch(lastkey){
 					case SDLK_7:
 						if (kbhits[SDLK_LSHIFT]) {
@@ -23,6 +23,8 @@
 */
 
 #include <SDL.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "af80.h"
 #include "bit3.h"
@@ -32,6 +34,7 @@
 #include "config.h"
 #include "filter_ntsc.h"
 #include "log.h"
+#include "palette_expand.h"
 #ifdef PAL_BLENDING
 #include "pal_blending.h"
 #endif /* PAL_BLENDING */
@@ -108,8 +111,15 @@ void SDL_VIDEO_UpdatePaletteLookup(VIDEOMODE_MODE_t mode, int bpp_32)
 	}
 }
 
+void PLATFORM_BeforeDisplayChange(void)
+{
+	/* The display thread reads the video mode parameters and the palette. */
+	SDL_VIDEO_StopDisplayThread();
+}
+
 void PLATFORM_PaletteUpdate(void)
 {
+	SDL_VIDEO_StopDisplayThread();
 #ifdef NTSC_FILTER
 	if (SDL_VIDEO_current_display_mode == VIDEOMODE_MODE_NTSC_FILTER)
 		FILTER_NTSC_Update(FILTER_NTSC_emu);
@@ -175,6 +185,8 @@ void PLATFORM_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, VIDE
 	   and Linux/KDE. */
 	window_maximised = windowed && res->width == desktop_resolution.width;
 
+	SDL_VIDEO_StopDisplayThread();
+
 #if HAVE_WINDOWS_H
 	/* On Windows, choose Windib or DirectX backend when switching between
 	   fullscreen<->windowed. */
@@ -295,8 +307,214 @@ int PLATFORM_WindowMaximised(void)
 	return window_maximised;
 }
 
+/* Display thread. When it is enabled, PLATFORM_DisplayScreen() copies
+   Screen_atari to a two-slot frame queue, and a separate thread converts the
+   frames (palette lookup, scaling, NTSC filter) to off-screen buffers laid
+   out like the display surface. SDL 1.2 supports video calls on the main
+   thread only, so locking the surface, copying the latest converted frame to
+   it and flipping stay in PLATFORM_DisplayScreen(). Thanks to that, an
+   expensive conversion runs in parallel with the emulation, at the cost of
+   one frame of latency. The thread is used only in software mode and only in
+   display modes that depend on nothing but Screen_atari and the lookup
+   tables. It is stopped before the main thread changes the video mode
+   parameters, the display surface or the palette (PLATFORM_BeforeDisplayChange()
+   is called before VIDEOMODE_* and Colours_table are recomputed), and restarted
+   with the next frame.
+
+   Buffer indices are exchanged under an SDL mutex, twice per frame; the
+   display thread waits on a condition variable while it has no frame to
+   convert. */
+int SDL_VIDEO_display_thread = FALSE;
+
+static SDL_Thread *display_thread = NULL;
+static SDL_mutex *frame_mutex = NULL;
+static SDL_cond *frame_cond = NULL;
+/* Copies of Screen_atari to convert. */
+static ULONG *frame_slots[2] = { NULL, NULL };
+/* Slot containing a frame not taken by the display thread yet, or -1. */
+static int frame_ready = -1;
+/* Slot being converted by the display thread, or -1. */
+static int frame_converting = -1;
+/* Converted frames. */
+static void *buffers[3] = { NULL, NULL, NULL };
+static int buffer_size = 0;
+/* Buffer containing a converted frame not displayed yet, or -1. */
+static int buffer_ready = -1;
+/* Buffer displayed last by the main thread, or -1. */
+static int buffer_shown = -1;
+static int display_thread_quit;
+static unsigned int frames_shown = 0;
+static unsigned int frames_dropped = 0;
+static unsigned int frames_repeated = 0;
+
+static int DisplayThread(void *data)
+{
+	SDL_LockMutex(frame_mutex);
+	for (;;) {
+		int slot;
+		int buffer;
+		while (!display_thread_quit && frame_ready < 0)
+			SDL_CondWait(frame_cond, frame_mutex);
+		if (display_thread_quit)
+			break;
+		slot = frame_converting = frame_ready;
+		frame_ready = -1;
+		/* Any buffer that is neither waiting for nor being displayed. */
+		for (buffer = 0; buffer == buffer_ready || buffer == buffer_shown; buffer++);
+		SDL_UnlockMutex(frame_mutex);
+		SDL_VIDEO_SW_DrawFrame(frame_slots[slot], buffers[buffer]);
+		SDL_LockMutex(frame_mutex);
+		frame_converting = -1;
+		if (buffer_ready >= 0)
+			/* The previous converted frame was never displayed. */
+			frames_dropped++;
+		buffer_ready = buffer;
+	}
+	SDL_UnlockMutex(frame_mutex);
+	return 0;
+}
+
+static int StartDisplayThread(void)
+{
+	int size = SDL_VIDEO_SW_BufferSize();
+	int i;
+	if (frame_mutex == NULL) {
+		frame_mutex = SDL_CreateMutex();
+		frame_cond = SDL_CreateCond();
+		if (frame_mutex == NULL || frame_cond == NULL) {
+			Log_print("Cannot create display thread synchronisation objects: %s", SDL_GetError());
+			SDL_VIDEO_display_thread = FALSE;
+			return FALSE;
+		}
+		frame_slots[0] = (ULONG *) Util_malloc(Screen_WIDTH * Screen_HEIGHT);
+		frame_slots[1] = (ULONG *) Util_malloc(Screen_WIDTH * Screen_HEIGHT);
+	}
+	if (size > buffer_size) {
+		for (i = 0; i < 3; i++)
+			buffers[i] = Util_realloc(buffers[i], size);
+		buffer_size = size;
+	}
+	/* Lines the blitters skip, such as 100% scanlines, must be black. */
+	for (i = 0; i < 3; i++)
+		memset(buffers[i], 0, size);
+	frame_ready = frame_converting = -1;
+	buffer_ready = buffer_shown = -1;
+	display_thread_quit = FALSE;
+	display_thread = SDL_CreateThread(&DisplayThread, NULL);
+	if (display_thread == NULL) {
+		Log_print("Cannot start display thread: %s", SDL_GetError());
+		SDL_VIDEO_display_thread = FALSE;
+		return FALSE;
+	}
+	return TRUE;
+}
+
+void SDL_VIDEO_StopDisplayThread(void)
+{
+	if (display_thread == NULL)
+		return;
+	SDL_LockMutex(frame_mutex);
+	display_thread_quit = TRUE;
+	SDL_CondSignal(frame_cond);
+	SDL_UnlockMutex(frame_mutex);
+	SDL_WaitThread(display_thread, NULL);
+	display_thread = NULL;
+}
+
+/* Returns TRUE if the current frame can be passed to the display thread,
+   starting the thread if needed. */
+static int UseDisplayThread(void)
+{
+	if (!SDL_VIDEO_display_thread || SDL_VIDEO_screen == NULL
+#if HAVE_OPENGL
+	    || SDL_VIDEO_opengl
+#endif
+	    || (SDL_VIDEO_current_display_mode != VIDEOMODE_MODE_NORMAL
+#ifdef NTSC_FILTER
+	        && SDL_VIDEO_current_display_mode != VIDEOMODE_MODE_NTSC_FILTER
+#endif
+	       ))
+		return FALSE;
+	return display_thread != NULL || StartDisplayThread();
+}
+
+/* Copies Screen_atari to a free slot of the frame queue. If the display thread
+   didn't take the previous frame yet, it is replaced. */
+static void QueueFrame(void)
+{
+	int slot;
+	SDL_LockMutex(frame_mutex);
+	if (frame_ready >= 0) {
+		slot = frame_ready;
+		frame_ready = -1;
+		frames_dropped++;
+	}
+	else
+		slot = frame_converting == 0 ? 1 : 0;
+	SDL_UnlockMutex(frame_mutex);
+	memcpy(frame_slots[slot], Screen_atari, Screen_WIDTH * Screen_HEIGHT);
+	SDL_LockMutex(frame_mutex);
+	frame_ready = slot;
+	SDL_CondSignal(frame_cond);
+	SDL_UnlockMutex(frame_mutex);
+}
+
+/* Displays the latest frame converted by the display thread. If no new frame
+   was converted since the last call, the last one is displayed again as it
+   is, without converting it again. */
+static void ShowFrame(void)
+{
+	int repeat;
+	SDL_LockMutex(frame_mutex);
+	repeat = buffer_ready < 0;
+	if (!repeat) {
+		buffer_shown = buffer_ready;
+		buffer_ready = -1;
+	}
+	SDL_UnlockMutex(frame_mutex);
+	if (buffer_shown < 0)
+		/* Nothing converted yet. */
+		return;
+	if (repeat)
+		frames_repeated++;
+	else
+		frames_shown++;
+	/* The display thread doesn't write to buffer_shown. */
+	SDL_VIDEO_SW_DisplayBuffer(buffers[buffer_shown]);
+}
+
+static void FreeDisplayThread(void)
+{
+	int i;
+	SDL_VIDEO_StopDisplayThread();
+	if (frames_shown != 0)
+		Log_print("Display thread: %u frames shown, %u dropped, %u repeated",
+		          frames_shown, frames_dropped, frames_repeated);
+	frames_shown = frames_dropped = frames_repeated = 0;
+	if (frame_mutex != NULL) {
+		SDL_DestroyCond(frame_cond);
+		SDL_DestroyMutex(frame_mutex);
+		frame_cond = NULL;
+		frame_mutex = NULL;
+		free(frame_slots[0]);
+		free(frame_slots[1]);
+		frame_slots[0] = frame_slots[1] = NULL;
+	}
+	for (i = 0; i < 3; i++) {
+		free(buffers[i]);
+		buffers[i] = NULL;
+	}
+	buffer_size = 0;
+}
+
 void PLATFORM_DisplayScreen(void)
 {
+	if (UseDisplayThread()) {
+		QueueFrame();
+		ShowFrame();
+		return;
+	}
+	SDL_VIDEO_StopDisplayThread();
 #if HAVE_OPENGL
 	if (SDL_VIDEO_opengl)
 		SDL_VIDEO_GL_DisplayScreen();
@@ -319,6 +537,8 @@ int SDL_VIDEO_ReadConfig(char *option, char *parameters)
 		return (SDL_VIDEO_interpolate_scanlines = Util_sscanbool(parameters)) != -1;
 	else if (strcmp(option, "VIDEO_VSYNC") == 0)
 		return (SDL_VIDEO_vsync = Util_sscanbool(parameters)) != -1;
+	else if (strcmp(option, "VIDEO_THREAD") == 0)
+		return (SDL_VIDEO_display_thread = Util_sscanbool(parameters)) != -1;
 #if HAVE_OPENGL
 	else if (strcmp(option, "VIDEO_ACCEL") == 0)
 		return (currently_opengl = SDL_VIDEO_opengl = Util_sscanbool(parameters)) != -1;
@@ -337,6 +557,7 @@ void SDL_VIDEO_WriteConfig(FILE *fp)
 	fprintf(fp, "SCANLINES_PERCENTAGE=%d\n", SDL_VIDEO_scanlines_percentage);
 	fprintf(fp, "INTERPOLATE_SCANLINES=%d\n", SDL_VIDEO_interpolate_scanlines);
 	fprintf(fp, "VIDEO_VSYNC=%d\n", SDL_VIDEO_vsync);
+	fprintf(fp, "VIDEO_THREAD=%d\n", SDL_VIDEO_display_thread);
 #if HAVE_OPENGL
 	fprintf(fp, "VIDEO_ACCEL=%d\n", SDL_VIDEO_opengl);
 	SDL_VIDEO_GL_WriteConfig(fp);
@@ -380,6 +601,7 @@ void SDL_VIDEO_InitSDL(void)
 
 void SDL_VIDEO_QuitSDL(void)
 {
+	SDL_VIDEO_StopDisplayThread();
 	if (SDL_VIDEO_screen != NULL) {
 #if HAVE_OPENGL
 		if (currently_opengl)
@@ -428,6 +650,10 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 			SDL_VIDEO_vsync = TRUE;
 		else if (strcmp(argv[i], "-no-vsync") == 0)
 			SDL_VIDEO_vsync = FALSE;
+		else if (strcmp(argv[i], "-video-thread") == 0)
+			SDL_VIDEO_display_thread = TRUE;
+		else if (strcmp(argv[i], "-no-video-thread") == 0)
+			SDL_VIDEO_display_thread = FALSE;
 		else {
 			if (strcmp(argv[i], "-help") == 0) {
 				help_only = TRUE;
@@ -440,6 +666,8 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 #endif /* HAVE_OPENGL */
 				Log_print("\t-vsync            Synchronize display to vertical retrace");
 				Log_print("\t-no-vsync         Don't synchronize display to vertical retrace");
+				Log_print("\t-video-thread     Convert the screen in a separate thread");
+				Log_print("\t-no-video-thread  Convert the screen in the emulation thread");
 			}
 			argv[j++] = argv[i];
 		}
@@ -478,6 +706,7 @@ int SDL_VIDEO_Initialise(int *argc, char *argv[])
 
 void SDL_VIDEO_Exit(void)
 {
+	FreeDisplayThread();
 	SDL_VIDEO_QuitSDL();
 #ifdef NTSC_FILTER
 	if (FILTER_NTSC_emu)
@@ -502,59 +731,12 @@ void SDL_VIDEO_BlitNormal8(Uint32 *dest, Uint8 *src, int pitch, int width, int h
 
 void SDL_VIDEO_BlitNormal16(Uint32 *dest, Uint8 *src, int pitch, int width, int height, Uint16 *palette16)
 {
-	register Uint32 quad;
-	register Uint32 *start32 = dest;
-	register Uint8 c;
-	register int pos;
-	int width_32;
-	if (width & 0x01)
-		width_32 = width + 1;
-	else
-		width_32 = width;
-	while (height > 0) {
-		pos = width_32;
-		do {
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-			pos--;
-			c = src[pos];
-			quad = palette16[c];
-			pos--;
-			c = src[pos];
-			quad += palette16[c] << 16;
-#else
-			pos--;
-			c = src[pos];
-			quad = palette16[c] << 16;
-			pos--;
-			c = src[pos];
-			quad += palette16[c];
-#endif
-			start32[pos >> 1] = quad;
-		} while (pos > 0);
-		src += Screen_WIDTH;
-		start32 += pitch;
-		height--;
-	}
+	PALETTE_EXPAND_Blit16(dest, pitch * 4, src, Screen_WIDTH, width, height, 1, 0, FALSE, palette16);
 }
 
 void SDL_VIDEO_BlitNormal32(Uint32 *dest, Uint8 *src, int pitch, int width, int height, Uint32 *palette32)
 {
-	register Uint32 quad;
-	register Uint32 *start32 = dest;
-	register Uint8 c;
-	register int pos;
-	while (height > 0) {
-		pos = width;
-		do {
-			pos--;
-			c = src[pos];
-			quad = palette32[c];
-			start32[pos] = quad;
-		} while (pos > 0);
-		src += Screen_WIDTH;
-		start32 += pitch;
-		height--;
-	}
+	PALETTE_EXPAND_Blit32(dest, pitch * 4, src, Screen_WIDTH, width, height, 1, 0, FALSE, palette32);
 }
 
 void SDL_VIDEO_BlitXEP80_8(Uint32 *dest, Uint8 *src, int pitch, int width, int height)
@@ -570,59 +752,12 @@ void SDL_VIDEO_BlitXEP80_8(Uint32 *dest, Uint8 *src, int pitch, int width, int h
 
 void SDL_VIDEO_BlitXEP80_16(Uint32 *dest, Uint8 *src, int pitch, int width, int height, Uint16 *palette16)
 {
-	register Uint32 quad;
-	register Uint32 *start32 = dest;
-	register Uint8 c;
-	register int pos;
-	int width_32;
-	if (width & 0x01)
-		width_32 = width + 1;
-	else
-		width_32 = width;
-	while (height > 0) {
-		pos = width_32;
-		do {
-#if SDL_BYTEORDER == SDL_BIG_ENDIAN
-			pos--;
-			c = src[pos];
-			quad = palette16[c];
-			pos--;
-			c = src[pos];
-			quad += palette16[c] << 16;
-#else
-			pos--;
-			c = src[pos];
-			quad = palette16[c] << 16;
-			pos--;
-			c = src[pos];
-			quad += palette16[c];
-#endif
-			start32[pos >> 1] = quad;
-		} while (pos > 0);
-		src += XEP80_SCRN_WIDTH;
-		start32 += pitch;
-		height--;
-	}
+	PALETTE_EXPAND_Blit16(dest, pitch * 4, src, XEP80_SCRN_WIDTH, width, height, 1, 0, FALSE, palette16);
 }
 
 void SDL_VIDEO_BlitXEP80_32(Uint32 *dest, Uint8 *src, int pitch, int width, int height, Uint32 *palette32)
 {
-	register Uint32 quad;
-	register Uint32 *start32 = dest;
-	register Uint8 c;
-	register int pos;
-	while (height > 0) {
-		pos = width;
-		do {
-			pos--;
-			c = src[pos];
-			quad = palette32[c];
-			start32[pos] = quad;
-		} while (pos > 0);
-		src += XEP80_SCRN_WIDTH;
-		start32 += pitch;
-		height--;
-	}
+	PALETTE_EXPAND_Blit32(dest, pitch * 4, src, XEP80_SCRN_WIDTH, width, height, 1, 0, FALSE, palette32);
 }
 
 void SDL_VIDEO_BlitProto80_8(Uint32 *dest, int first_column, int last_column, int pitch, int first_line, int last_line)
@@ -965,6 +1100,8 @@ void SDL_VIDEO_SetScanlinesPercentage(int value)
 		value = 0;
 	else if (value > 100)
 		value = 100;
+	/* Drawing the scanlines changes. */
+	SDL_VIDEO_StopDisplayThread();
 	SDL_VIDEO_scanlines_percentage = value;
 #if HAVE_OPENGL
 	SDL_VIDEO_GL_ScanlinesPercentageChanged();
@@ -973,6 +1110,7 @@ void SDL_VIDEO_SetScanlinesPercentage(int value)
 
 void SDL_VIDEO_SetInterpolateScanlines(int value)
 {
+	SDL_VIDEO_StopDisplayThread();
 	SDL_VIDEO_interpolate_scanlines = value;
 #if HAVE_OPENGL
 	SDL_VIDEO_GL_InterpolateScanlinesChanged();
@@ -40,6 +40,14 @@ int SDL_VIDEO_SetVsync(int value);
 int SDL_VIDEO_ToggleVsync(void);
 extern int SDL_VIDEO_vsync_available;
 
+/* Get/set converting the screen for display in a separate thread (software
+   mode only). Dropped and repeated frames are reported on exit. */
+extern int SDL_VIDEO_display_thread;
+/* Wait until the display thread finishes converting and stop it. Must be
+   called before modifying the display surface or data used by the software
+   blitters from the main thread. The thread restarts with the next frame. */
+void SDL_VIDEO_StopDisplayThread(void);
+
 /* Get/set brightness of scanlines. (0=none, 100=completely black). */
 /* Use SDL_VIDEO_SetScanlinesPercentage() to set this value. */
 extern int SDL_VIDEO_scanlines_percentage;
@@ -34,6 +34,7 @@
 #include "config.h"
 #include "filter_ntsc.h"
 #include "log.h"
+#include "palette_expand.h"
 #include "pbi_proto80.h"
 #ifdef PAL_BLENDING
 #include "pal_blending.h"
@@ -52,9 +53,19 @@
 static int fullscreen = 1;
 
 int SDL_VIDEO_SW_bpp = 0;
+int SDL_VIDEO_SW_scanlines = FALSE;
+
+/* Frame being displayed - Screen_atari or a copy of it made for the display
+   thread. */
+static ULONG *source_screen;
+/* Where the blitters draw - the display surface, or a buffer with the same
+   pitch and size filled by the display thread. */
+static Uint8 *target_pixels;
+static int target_pitch;
 
 static void DisplayWithoutScaling(void);
 static void DisplayWithScaling(void);
+static void DisplayWithIntegerScaling(void);
 static void DisplayRotated(void);
 #ifdef NTSC_FILTER
 static void DisplayNTSCEmu(void);
@@ -190,6 +201,18 @@ static void SetVideoMode(int w, int h, int bpp)
 	ModeInfo();
 }
 
+/* Returns 2 or 3 if the screen is enlarged exactly that many times in both
+   directions, or 0 otherwise. */
+static int IntegerScale(void)
+{
+	int scale;
+	for (scale = 2; scale <= 3; scale++) {
+		if (VIDEOMODE_dest_width == VIDEOMODE_src_width * scale && VIDEOMODE_dest_height == VIDEOMODE_src_height * scale)
+			return scale;
+	}
+	return 0;
+}
+
 void SDL_VIDEO_SW_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, VIDEOMODE_MODE_t mode, int rotate90)
 {
 	int old_bpp = SDL_VIDEO_screen == NULL ? 0 : SDL_VIDEO_screen->format->BitsPerPixel;
@@ -247,6 +270,8 @@ void SDL_VIDEO_SW_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed,
 #endif /* PAL_BLENDING */
 		else if (VIDEOMODE_src_width == VIDEOMODE_dest_width && VIDEOMODE_src_height == VIDEOMODE_dest_height)
 			blit_funcs[0] = &DisplayWithoutScaling;
+		else if (SDL_VIDEO_screen->format->BitsPerPixel != 8 && IntegerScale() != 0)
+			blit_funcs[0] = &DisplayWithIntegerScaling;
 		else
 			blit_funcs[0] = &DisplayWithScaling;
 	}
@@ -471,9 +496,9 @@ static void scanLines_32(void* pBuffer, int width, int height, int pitch, int sc
 static void DisplayXEP80(void)
 {
 	static int xep80Frame = 0;
-	int pitch4 = SDL_VIDEO_screen->pitch / 2;
+	int pitch4 = target_pitch / 2;
 	UBYTE *screen;
-	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	Uint8 *pixels = (Uint8 *) target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 	xep80Frame++;
 	if (xep80Frame == 60) xep80Frame = 0;
 	if (xep80Frame > 29) {
@@ -492,12 +517,12 @@ static void DisplayXEP80(void)
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
 		SDL_VIDEO_BlitXEP80_16((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	default:
 		pixels += VIDEOMODE_dest_offset_left * 4;
 		SDL_VIDEO_BlitXEP80_32((Uint32 *)pixels, screen, pitch4, VIDEOMODE_src_width, VIDEOMODE_src_height, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 	}
 }
 #endif
@@ -505,30 +530,30 @@ static void DisplayXEP80(void)
 #ifdef NTSC_FILTER
 static void DisplayNTSCEmu(void)
 {
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	Uint8 *pixels = (Uint8*)target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
 		/* blit atari image, doubled vertically */
 		atari_ntsc_blit_rgb16(FILTER_NTSC_emu,
-		                      (ATARI_NTSC_IN_T *) ((UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left),
+		                      (ATARI_NTSC_IN_T *) ((UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left),
 		                      Screen_WIDTH,
 		                      VIDEOMODE_src_width,
 		                      VIDEOMODE_src_height,
 		                      pixels,
-		                      SDL_VIDEO_screen->pitch * 2);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		                      target_pitch * 2);
+		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	case 32:
 		pixels += VIDEOMODE_dest_offset_left * 4;
 		atari_ntsc_blit_argb32(FILTER_NTSC_emu,
-		                      (ATARI_NTSC_IN_T *) ((UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left),
+		                      (ATARI_NTSC_IN_T *) ((UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left),
 		                       Screen_WIDTH,
 		                       VIDEOMODE_src_width,
 		                       VIDEOMODE_src_height,
 		                       pixels,
-		                       SDL_VIDEO_screen->pitch * 2);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		                       target_pitch * 2);
+		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	}
 }
@@ -541,8 +566,8 @@ static void DisplayProto80(void)
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
 	int first_line = VIDEOMODE_src_offset_top;
 	int last_line = first_line + VIDEOMODE_src_height;
-	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	int pitch4 = target_pitch / 2;
+	Uint8 *pixels = (Uint8*)target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 
 	
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
@@ -553,12 +578,12 @@ static void DisplayProto80(void)
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
 		SDL_VIDEO_BlitProto80_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	default:
 		pixels += VIDEOMODE_dest_offset_left * 4;
 		SDL_VIDEO_BlitProto80_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 	}
 }
 #endif
@@ -570,8 +595,8 @@ static void DisplayAF80(void)
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
 	int first_line = VIDEOMODE_src_offset_top;
 	int last_line = first_line + VIDEOMODE_src_height;
-	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	int pitch4 = target_pitch / 2;
+	Uint8 *pixels = (Uint8*)target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 
 	static int AF80Frame = 0;
 	int blink;
@@ -587,12 +612,12 @@ static void DisplayAF80(void)
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
 		SDL_VIDEO_BlitAF80_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	default:
 		pixels += VIDEOMODE_dest_offset_left * 4;
 		SDL_VIDEO_BlitAF80_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 	}
 }
 #endif
@@ -604,8 +629,8 @@ static void DisplayBIT3(void)
 	int last_column = (VIDEOMODE_src_offset_left + VIDEOMODE_src_width) / 8;
 	int first_line = VIDEOMODE_src_offset_top;
 	int last_line = first_line + VIDEOMODE_src_height;
-	int pitch4 = SDL_VIDEO_screen->pitch / 2;
-	Uint8 *pixels = (Uint8*)SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	int pitch4 = target_pitch / 2;
+	Uint8 *pixels = (Uint8*)target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 
 	static int BIT3Frame = 0;
 	int blink;
@@ -621,12 +646,12 @@ static void DisplayBIT3(void)
 	case 16:
 		pixels += VIDEOMODE_dest_offset_left * 2;
 		SDL_VIDEO_BlitBIT3_16((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp16);
-		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_16((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 		break;
 	default:
 		pixels += VIDEOMODE_dest_offset_left * 4;
 		SDL_VIDEO_BlitBIT3_32((Uint32 *)pixels, first_column, last_column, pitch4, first_line, last_line, blink, SDL_PALETTE_buffer.bpp32);
-		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, SDL_VIDEO_screen->pitch, SDL_VIDEO_scanlines_percentage);
+		scanLines_32((void *)pixels, VIDEOMODE_dest_width, VIDEOMODE_dest_height, target_pitch, SDL_VIDEO_scanlines_percentage);
 	}
 }
 #endif
@@ -634,9 +659,9 @@ static void DisplayBIT3(void)
 static void DisplayRotated(void)
 {
 	unsigned int x, y;
-	register Uint32 *start32 = (Uint32 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch / 4 * VIDEOMODE_dest_offset_top + VIDEOMODE_dest_offset_left / 2;
-	int pitch4 = SDL_VIDEO_screen->pitch / 4 - VIDEOMODE_dest_width / 2;
-	UBYTE *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	register Uint32 *start32 = (Uint32 *) target_pixels + target_pitch / 4 * VIDEOMODE_dest_offset_top + VIDEOMODE_dest_offset_left / 2;
+	int pitch4 = target_pitch / 4 - VIDEOMODE_dest_width / 2;
+	UBYTE *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
 	for (y = 0; y < VIDEOMODE_dest_height; y++) {
 		for (x = 0; x < VIDEOMODE_dest_width / 2; x++) {
 			Uint8 left = screen[Screen_WIDTH * (x * 2) + VIDEOMODE_src_width - y];
@@ -653,9 +678,9 @@ static void DisplayRotated(void)
 
 static void DisplayWithoutScaling(void)
 {
-	int pitch4 = SDL_VIDEO_screen->pitch / 4;
-	UBYTE *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
-	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	int pitch4 = target_pitch / 4;
+	UBYTE *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint8 *pixels = (Uint8 *) target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	/* Possible values are 8, 16 and 32, as checked earlier in the
 	 * PLATFORM_SetVideoMode() function. */
@@ -673,12 +698,37 @@ static void DisplayWithoutScaling(void)
 	}
 }
 
+/* Faster variant of DisplayWithScaling() for 2x and 3x enlargement. Draws
+   scanlines only if SDL_VIDEO_SW_scanlines is set, so that by default the
+   picture is the same as with DisplayWithScaling(). */
+static void DisplayWithIntegerScaling(void)
+{
+	int scale = IntegerScale();
+	UBYTE *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint8 *pixels = (Uint8 *) target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
+	int scanlines = SDL_VIDEO_SW_scanlines ? SDL_VIDEO_scanlines_percentage : 0;
+	if (scanlines < 0)
+		scanlines = 0;
+	else if (scanlines > 100)
+		scanlines = 100;
+	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
+	/* 8 BPP is handled by DisplayWithScaling(). */
+	case 16:
+		pixels += VIDEOMODE_dest_offset_left * 2;
+		PALETTE_EXPAND_Blit16(pixels, target_pitch, screen, Screen_WIDTH, VIDEOMODE_src_width, VIDEOMODE_src_height, scale, scanlines, SDL_VIDEO_interpolate_scanlines, SDL_PALETTE_buffer.bpp16);
+		break;
+	default: /* SDL_VIDEO_screen->format->BitsPerPixel == 32 */
+		pixels += VIDEOMODE_dest_offset_left * 4;
+		PALETTE_EXPAND_Blit32(pixels, target_pitch, screen, Screen_WIDTH, VIDEOMODE_src_width, VIDEOMODE_src_height, scale, scanlines, SDL_VIDEO_interpolate_scanlines, SDL_PALETTE_buffer.bpp32);
+	}
+}
+
 static void DisplayWithScaling(void)
 {
 	register Uint32 quad;
 	register int x;
-	register Uint8 *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
-	register Uint32 *pixels = (Uint32 *) SDL_VIDEO_screen->pixels;
+	register Uint8 *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	register Uint32 *pixels = (Uint32 *) target_pixels;
 	int i;
 	int y = 0;
 	int w1;
@@ -687,7 +737,7 @@ static void DisplayWithScaling(void)
 	register int dx = w / VIDEOMODE_dest_width;
 	register int yy;
 	int pos;
-	int pitch4 = SDL_VIDEO_screen->pitch / 4;
+	int pitch4 = target_pitch / 4;
 	int dy = h / VIDEOMODE_dest_height;
 	int init_x = (VIDEOMODE_src_width << 16) - 0x4000;
 
@@ -792,9 +842,9 @@ static void DisplayWithScaling(void)
 #ifdef PAL_BLENDING
 static void DisplayPalBlending(void)
 {
-	int pitch4 = SDL_VIDEO_screen->pitch / 4;
-	UBYTE *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
-	Uint8 *pixels = (Uint8 *) SDL_VIDEO_screen->pixels + SDL_VIDEO_screen->pitch * VIDEOMODE_dest_offset_top;
+	int pitch4 = target_pitch / 4;
+	UBYTE *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint8 *pixels = (Uint8 *) target_pixels + target_pitch * VIDEOMODE_dest_offset_top;
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	/* Possible values are 8, 16 and 32, as checked earlier in the
 	 * PLATFORM_SetVideoMode() function. */
@@ -810,9 +860,9 @@ static void DisplayPalBlending(void)
 
 static void DisplayPalBlendingScaled(void)
 {
-	int pitch4 = SDL_VIDEO_screen->pitch / 4;
-	Uint8 *screen = (UBYTE *)Screen_atari + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
-	Uint32 *pixels = (Uint32 *) SDL_VIDEO_screen->pixels;
+	int pitch4 = target_pitch / 4;
+	Uint8 *screen = (UBYTE *)source_screen + Screen_WIDTH * VIDEOMODE_src_offset_top + VIDEOMODE_src_offset_left;
+	Uint32 *pixels = (Uint32 *) target_pixels;
 	switch (SDL_VIDEO_screen->format->BitsPerPixel) {
 	/* Possible values are 8, 16 and 32, as checked earlier in the
 	 * PLATFORM_SetVideoMode() function. */
@@ -827,6 +877,17 @@ static void DisplayPalBlendingScaled(void)
 }
 #endif /* PAL_BLENDING */
 
+/* Shows the surface's contents after drawing. */
+static void UpdateScreen(void)
+{
+	/* SDL_UpdateRect is faster than SDL_Flip for a software surface, because
+	   it copies only the used part of the screen. */
+	if (SDL_VIDEO_screen->flags & SDL_DOUBLEBUF)
+		SDL_Flip(SDL_VIDEO_screen);
+	else
+		SDL_UpdateRect(SDL_VIDEO_screen, VIDEOMODE_dest_offset_left, VIDEOMODE_dest_offset_top, VIDEOMODE_dest_width, VIDEOMODE_dest_height);
+}
+
 void SDL_VIDEO_SW_DisplayScreen(void)
 {
 	if (SDL_LockSurface(SDL_VIDEO_screen) != 0)
@@ -838,15 +899,47 @@ void SDL_VIDEO_SW_DisplayScreen(void)
 		   mode gets re-enabled, surface locking will work again and screen
 		   displaying will be restored */
 		   return;
+	source_screen = Screen_atari;
+	target_pixels = (Uint8 *) SDL_VIDEO_screen->pixels;
+	target_pitch = SDL_VIDEO_screen->pitch;
 	/* Use function corresponding to the current_display_mode. */
 	(*blit_funcs[SDL_VIDEO_current_display_mode])();
 	SDL_UnlockSurface(SDL_VIDEO_screen);
-	/* SDL_UpdateRect is faster than SDL_Flip for a software surface, because
-	   it copies only the used part of the screen. */
-	if (SDL_VIDEO_screen->flags & SDL_DOUBLEBUF)
-		SDL_Flip(SDL_VIDEO_screen);
-	else
-		SDL_UpdateRect(SDL_VIDEO_screen, VIDEOMODE_dest_offset_left, VIDEOMODE_dest_offset_top, VIDEOMODE_dest_width, VIDEOMODE_dest_height);
+	UpdateScreen();
+}
+
+int SDL_VIDEO_SW_BufferSize(void)
+{
+	return SDL_VIDEO_screen->pitch * SDL_VIDEO_screen->h;
+}
+
+void SDL_VIDEO_SW_DrawFrame(ULONG *frame, void *buffer)
+{
+	source_screen = frame;
+	target_pixels = (Uint8 *) buffer;
+	target_pitch = SDL_VIDEO_screen->pitch;
+	(*blit_funcs[SDL_VIDEO_current_display_mode])();
+}
+
+void SDL_VIDEO_SW_DisplayBuffer(void const *buffer)
+{
+	int pitch = SDL_VIDEO_screen->pitch;
+	int offset = pitch * VIDEOMODE_dest_offset_top + VIDEOMODE_dest_offset_left * SDL_VIDEO_screen->format->BytesPerPixel;
+	int width = VIDEOMODE_dest_width * SDL_VIDEO_screen->format->BytesPerPixel;
+	Uint8 const *src = (Uint8 const *) buffer + offset;
+	Uint8 *dest;
+	unsigned int y;
+	if (SDL_LockSurface(SDL_VIDEO_screen) != 0)
+		/* See SDL_VIDEO_SW_DisplayScreen(). */
+		return;
+	dest = (Uint8 *) SDL_VIDEO_screen->pixels + offset;
+	for (y = 0; y < VIDEOMODE_dest_height; y++) {
+		memcpy(dest, src, width);
+		src += pitch;
+		dest += pitch;
+	}
+	SDL_UnlockSurface(SDL_VIDEO_screen);
+	UpdateScreen();
 }
 
 int SDL_VIDEO_SW_ReadConfig(char *option, char *parameters)
@@ -858,6 +951,8 @@ int SDL_VIDEO_SW_ReadConfig(char *option, char *parameters)
 		else
 			SDL_VIDEO_SW_bpp = value;
 	}
+	else if (strcmp(option, "VIDEO_SW_SCANLINES") == 0)
+		return (SDL_VIDEO_SW_scanlines = Util_sscanbool(parameters)) != -1;
 	else
 		return FALSE;
 	return TRUE;
@@ -866,6 +961,7 @@ int SDL_VIDEO_SW_ReadConfig(char *option, char *parameters)
 void SDL_VIDEO_SW_WriteConfig(FILE *fp)
 {
 	fprintf(fp, "VIDEO_BPP=%d\n", SDL_VIDEO_SW_bpp);
+	fprintf(fp, "VIDEO_SW_SCANLINES=%d\n", SDL_VIDEO_SW_scanlines);
 }
 
 int SDL_VIDEO_SW_Initialise(int *argc, char *argv[])
@@ -885,9 +981,16 @@ int SDL_VIDEO_SW_Initialise(int *argc, char *argv[])
 			}
 			else a_m = TRUE;
 		}
+		else if (strcmp(argv[i], "-sw-scanlines") == 0)
+			SDL_VIDEO_SW_scanlines = TRUE;
+		else if (strcmp(argv[i], "-no-sw-scanlines") == 0)
+			SDL_VIDEO_SW_scanlines = FALSE;
 		else {
-			if (strcmp(argv[i], "-help") == 0)
+			if (strcmp(argv[i], "-help") == 0) {
 				Log_print("\t-bpp <num>        Host color depth (0 = autodetect)");
+				Log_print("\t-sw-scanlines     Draw scanlines in 2x/3x software display");
+				Log_print("\t-no-sw-scanlines  Don't draw scanlines in 2x/3x software display");
+			}
 			argv[j++] = argv[i];
 		}
 
@@ -1,10 +1,23 @@
 #ifndef SDL_VIDEO_SW_H_
 #define SDL_VIDEO_SW_H_
 
+#include "atari.h"
 #include "platform.h"
 #include "videomode.h"
 
 void SDL_VIDEO_SW_DisplayScreen(void);
+
+/* Drawing through an off-screen buffer, for the display thread. The buffer
+   has the layout of the display surface and SDL_VIDEO_SW_BufferSize() bytes.
+   SDL_VIDEO_SW_DrawFrame() makes no SDL calls and may run on another thread,
+   as long as the video mode and lookup tables don't change meanwhile. */
+int SDL_VIDEO_SW_BufferSize(void);
+/* Draws FRAME (of size Screen_WIDTH x Screen_HEIGHT) to BUFFER, as
+   SDL_VIDEO_SW_DisplayScreen() would draw Screen_atari to the surface. */
+void SDL_VIDEO_SW_DrawFrame(ULONG *frame, void *buffer);
+/* Copies the drawn area of BUFFER to the display surface and shows it. Must
+   be called from the main thread. */
+void SDL_VIDEO_SW_DisplayBuffer(void const *buffer);
 void SDL_VIDEO_SW_PaletteUpdate(void);
 void SDL_VIDEO_SW_SetVideoMode(VIDEOMODE_resolution_t const *res, int windowed, VIDEOMODE_MODE_t mode, int rotate90);
 int SDL_VIDEO_SW_SupportsVideomode(VIDEOMODE_MODE_t mode, int stretch, int rotate90);
@@ -15,6 +28,11 @@ extern int SDL_VIDEO_SW_bpp;
 int SDL_VIDEO_SW_SetBpp(int value);
 int SDL_VIDEO_SW_ToggleBpp(void);
 
+/* Get/set drawing scanlines in the normal display mode when the window is
+   exactly 2x or 3x the Atari screen. Their brightness and interpolation
+   follow SDL_VIDEO_scanlines_percentage and SDL_VIDEO_interpolate_scanlines. */
+extern int SDL_VIDEO_SW_scanlines;
+
 /* Returns parameters of the current display pixel format. Used when computing
    lookup tables used for blitting the Atari screen to display surface. */
 void SDL_VIDEO_SW_GetPixelFormat(PLATFORM_pixel_format_t *format);
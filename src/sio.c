@@ -72,6 +72,35 @@ static int image_type[SIO_MAX_DRIVES];
 #define IMAGE_TYPE_PRO  2
 #define IMAGE_TYPE_VAPI 3
 static FILE *disk[SIO_MAX_DRIVES] = { NULL, NULL, NULL, NULL, NULL, NULL, NULL, NULL };
+/* The whole disk image is loaded at mount time and sectors are copied
+   from memory. Written sectors are flagged in dirty[] (indexed by sector
+   number, allocated on the first write) and written back to the file by
+   SIO_Sync() and on dismount. */
+static UBYTE *image[SIO_MAX_DRIVES];
+static ULONG image_size[SIO_MAX_DRIVES];
+static UBYTE *dirty[SIO_MAX_DRIVES];
+
+/* Decoded images are kept in a cache looked up by the contents of the
+   image file, so an image mounted again, or in several drives, is read
+   from the same memory and compressed images are uncompressed once. The
+   data is shared until a drive writes to it, which gives that drive a
+   private copy. Unused entries are kept up to IMAGE_CACHE_LIMIT bytes. */
+typedef struct image_cache_t {
+	struct image_cache_t *next;
+	UBYTE *raw; /* contents of the file; same as data if not compressed */
+	ULONG raw_size;
+	ULONG hash; /* of raw */
+	UBYTE *data;
+	ULONG size;
+	int refs; /* number of drives using the entry */
+} image_cache_t;
+
+#define IMAGE_CACHE_LIMIT (16 * 1024 * 1024)
+
+/* Most recently used first */
+static image_cache_t *image_cache = NULL;
+/* Entry holding image[], or NULL if the drive has a private copy */
+static image_cache_t *image_entry[SIO_MAX_DRIVES];
 static int sectorcount[SIO_MAX_DRIVES];
 static int sectorsize[SIO_MAX_DRIVES];
 /* these two are used by the 1450XLD parallel disk device */
@@ -157,6 +186,7 @@ Util_tmpbufdef(static, sio_tmpbuf[SIO_MAX_DRIVES])
 
 int SIO_last_op;
 int SIO_last_op_time = 0;
+int SIO_last_op_frame = 0;
 int SIO_last_drive;
 int SIO_last_sector;
 char SIO_status[256];
@@ -174,6 +204,8 @@ static int CommandIndex = 0;
 static UBYTE DataBuffer[256 + 3];
 static int DataIndex = 0;
 static int TransferStatus = SIO_NoFrame;
+
+int SIO_accel_divisor = -1;
 static int ExpectedBytes = 0;
 
 int ignore_header_writeprotect = FALSE;
@@ -181,6 +213,36 @@ int ignore_header_writeprotect = FALSE;
 int SIO_Initialise(int *argc, char *argv[])
 {
 	int i;
+	int j;
+
+	for (i = j = 1; i < *argc; i++) {
+		int i_a = (i + 1 < *argc);		/* is argument available? */
+		int a_m = FALSE;			/* error, argument missing! */
+
+		if (strcmp(argv[i], "-sio-accel") == 0) {
+			if (i_a) {
+				SIO_accel_divisor = Util_sscandec(argv[++i]);
+				if (SIO_accel_divisor < -1 || SIO_accel_divisor > 0x28) {
+					Log_print("Invalid SIO divisor - should be between -1 and 40");
+					return FALSE;
+				}
+			}
+			else a_m = TRUE;
+		}
+		else {
+			if (strcmp(argv[i], "-help") == 0)
+				Log_print("\t-sio-accel <n>    Disk drives send data at POKEY divisor n when the SIO\n"
+				          "\t                  patch is off (-1: stock speed, 10: US Doubler)");
+			argv[j++] = argv[i];
+		}
+
+		if (a_m) {
+			Log_print("Missing argument for '%s'", argv[i]);
+			return FALSE;
+		}
+	}
+	*argc = j;
+
 	for (i = 0; i < SIO_MAX_DRIVES; i++) {
 		strcpy(SIO_filename[i], "Off");
 		SIO_drive_status[i] = SIO_OFF;
@@ -192,6 +254,23 @@ int SIO_Initialise(int *argc, char *argv[])
 	return TRUE;
 }
 
+int SIO_ReadConfig(char *string, char *ptr)
+{
+	if (strcmp(string, "SIO_ACCEL_DIVISOR") == 0) {
+		int value = Util_sscandec(ptr);
+		if (value < -1 || value > 0x28)
+			return FALSE;
+		SIO_accel_divisor = value;
+	}
+	else return FALSE;
+	return TRUE;
+}
+
+void SIO_WriteConfig(FILE *fp)
+{
+	fprintf(fp, "SIO_ACCEL_DIVISOR=%d\n", SIO_accel_divisor);
+}
+
 /* umount disks so temporary files are deleted */
 void SIO_Exit(void)
 {
@@ -200,11 +279,218 @@ void SIO_Exit(void)
 		SIO_Dismount(i);
 }
 
+/* FNV-1a */
+static ULONG HashBytes(const UBYTE *p, ULONG size)
+{
+	ULONG hash = 2166136261U;
+	while (size-- > 0)
+		hash = (hash ^ *p++) * 16777619U;
+	return hash;
+}
+
+static image_cache_t *FindCached(const UBYTE *raw, ULONG raw_size, ULONG hash)
+{
+	image_cache_t **pe;
+	for (pe = &image_cache; *pe != NULL; pe = &(*pe)->next) {
+		image_cache_t *e = *pe;
+		if (e->hash == hash && e->raw_size == raw_size && memcmp(e->raw, raw, raw_size) == 0) {
+			/* move to front */
+			*pe = e->next;
+			e->next = image_cache;
+			image_cache = e;
+			return e;
+		}
+	}
+	return NULL;
+}
+
+/* Adds a cache entry that takes ownership of RAW and DATA. */
+static image_cache_t *AddCached(UBYTE *raw, ULONG raw_size, ULONG hash, UBYTE *data, ULONG size)
+{
+	image_cache_t *e = (image_cache_t *) Util_malloc(sizeof(image_cache_t));
+	e->raw = raw;
+	e->raw_size = raw_size;
+	e->hash = hash;
+	e->data = data;
+	e->size = size;
+	e->refs = 0;
+	e->next = image_cache;
+	image_cache = e;
+	return e;
+}
+
+/* Frees the least recently used entries no drive refers to, until they
+   take at most IMAGE_CACHE_LIMIT bytes. */
+static void TrimCache(void)
+{
+	for (;;) {
+		image_cache_t **pe;
+		image_cache_t **last = NULL;
+		image_cache_t *e;
+		ULONG unused = 0;
+		for (pe = &image_cache; *pe != NULL; pe = &(*pe)->next) {
+			if ((*pe)->refs == 0) {
+				unused += (*pe)->size + ((*pe)->raw != (*pe)->data ? (*pe)->raw_size : 0);
+				last = pe;
+			}
+		}
+		if (unused <= IMAGE_CACHE_LIMIT)
+			break;
+		e = *last;
+		*last = e->next;
+		if (e->raw != e->data)
+			free(e->raw);
+		free(e->data);
+		free(e);
+	}
+}
+
+static void UseCached(int unit, image_cache_t *e)
+{
+	e->refs++;
+	image_entry[unit] = e;
+	image[unit] = e->data;
+	image_size[unit] = e->size;
+}
+
+static void FreeImage(int unit)
+{
+	if (image_entry[unit] != NULL) {
+		image_entry[unit]->refs--;
+		image_entry[unit] = NULL;
+		TrimCache();
+	}
+	else
+		free(image[unit]);
+	image[unit] = NULL;
+	image_size[unit] = 0;
+}
+
+/* Reads the image file F into memory, uncompressing it if needed. Sets
+   *COMPRESSED if the file was compressed. */
+static int LoadImage(int unit, FILE *f, const char *filename, int *compressed)
+{
+	UBYTE *raw;
+	ULONG hash;
+	image_cache_t *e;
+	int len = Util_flen(f);
+	if (len < 0)
+		return FALSE;
+	raw = (UBYTE *) Util_malloc(len > 0 ? len : 1);
+	Util_rewind(f);
+	if (fread(raw, 1, len, f) != (size_t) len) {
+		free(raw);
+		return FALSE;
+	}
+	/* DCM or ATZ/ATR.GZ, XFZ/XFD.GZ */
+	*compressed = len > 0 && (raw[0] == 0xf9 || raw[0] == 0xfa || (raw[0] == 0x1f && len > 1 && raw[1] == 0x8b));
+	hash = HashBytes(raw, len);
+	e = FindCached(raw, len, hash);
+	if (e != NULL) {
+		free(raw);
+		UseCached(unit, e);
+		return TRUE;
+	}
+	if (*compressed) {
+		UBYTE *data;
+		int size;
+		if (raw[0] == 0x1f)
+			data = CompFile_ExtractGZToMemory(filename, &size);
+		else {
+			Util_rewind(f);
+			data = CompFile_DCMtoATRMemory(f, &size);
+		}
+		if (data == NULL) {
+			free(raw);
+			return FALSE;
+		}
+		UseCached(unit, AddCached(raw, len, hash, data, size));
+	}
+	else {
+		/* Kept private; shared only if the drive is read-only (see SIO_Mount). */
+		image_entry[unit] = NULL;
+		image[unit] = raw;
+		image_size[unit] = len;
+	}
+	return TRUE;
+}
+
+/* Copies SIZE bytes at OFFSET in the disk image to BUFFER. Returns the number
+   of bytes copied, less than SIZE at the end of the image. */
+static int ReadImage(int unit, ULONG offset, UBYTE *buffer, int size)
+{
+	if (offset >= image_size[unit])
+		return 0;
+	if ((ULONG) size > image_size[unit] - offset)
+		size = (int) (image_size[unit] - offset);
+	memcpy(buffer, image[unit] + offset, size);
+	return size;
+}
+
+static void WriteImage(int unit, int sector, ULONG offset, const UBYTE *buffer, int size)
+{
+	if (image_entry[unit] != NULL) {
+		/* copy on write */
+		ULONG len = image_size[unit];
+		UBYTE *copy = (UBYTE *) Util_malloc(len > 0 ? len : 1);
+		memcpy(copy, image[unit], len);
+		FreeImage(unit);
+		image[unit] = copy;
+		image_size[unit] = len;
+	}
+	if (offset + size > image_size[unit]) {
+		/* the file will grow, as it did with fwrite() */
+		image[unit] = (UBYTE *) Util_realloc(image[unit], offset + size);
+		memset(image[unit] + image_size[unit], 0, offset + size - image_size[unit]);
+		image_size[unit] = offset + size;
+	}
+	memcpy(image[unit] + offset, buffer, size);
+	if (dirty[unit] == NULL) {
+		dirty[unit] = (UBYTE *) Util_malloc(sectorcount[unit] + 1);
+		memset(dirty[unit], 0, sectorcount[unit] + 1);
+	}
+	dirty[unit][sector] = TRUE;
+}
+
+static void SectorPosition(int unit, int sector, int *sz, ULONG *ofs);
+
+/* Writes the dirty sectors of UNIT back to the image file. */
+static void FlushImage(int unit)
+{
+	int sector;
+	if (dirty[unit] == NULL)
+		return;
+	for (sector = 1; sector <= sectorcount[unit]; sector++) {
+		ULONG offset;
+		int size;
+		if (!dirty[unit][sector])
+			continue;
+		SectorPosition(unit, sector, &size, &offset);
+		if (offset + size > image_size[unit])
+			size = offset < image_size[unit] ? (int) (image_size[unit] - offset) : 0;
+		if (fseek(disk[unit], offset, SEEK_SET) != 0
+		 || fwrite(image[unit] + offset, 1, size, disk[unit]) != (size_t) size)
+			Log_print("Error writing sector %d to %s", sector, SIO_filename[unit]);
+	}
+	fflush(disk[unit]);
+	free(dirty[unit]);
+	dirty[unit] = NULL;
+}
+
+void SIO_Sync(void)
+{
+	int i;
+	for (i = 0; i < SIO_MAX_DRIVES; i++)
+		if (disk[i] != NULL)
+			FlushImage(i);
+}
+
 int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 {
 	FILE *f = NULL;
 	SIO_UnitStatus status = SIO_READ_WRITE;
 	struct AFILE_ATR_Header header;
+	int compressed;
 
 	/* avoid overruns in SIO_filename[] */
 	if (strlen(filename) >= FILENAME_MAX)
@@ -223,61 +509,19 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		status = SIO_READ_ONLY;
 	}
 
-	/* read header */
-	if (fread(&header, 1, sizeof(struct AFILE_ATR_Header), f) != sizeof(struct AFILE_ATR_Header)) {
+	/* read the image and its header */
+	if (!LoadImage(diskno - 1, f, filename, &compressed)) {
 		fclose(f);
 		return FALSE;
 	}
-
-	/* detect compressed image and uncompress */
-	switch (header.magic1) {
-	case 0xf9:
-	case 0xfa:
-		/* DCM */
-		{
-			FILE *f2 = Util_tmpopen(sio_tmpbuf[diskno - 1]);
-			if (f2 == NULL)
-				return FALSE;
-			Util_rewind(f);
-			if (!CompFile_DCMtoATR(f, f2)) {
-				Util_fclose(f2, sio_tmpbuf[diskno - 1]);
-				fclose(f);
-				return FALSE;
-			}
-			fclose(f);
-			f = f2;
-		}
-		Util_rewind(f);
-		if (fread(&header, 1, sizeof(struct AFILE_ATR_Header), f) != sizeof(struct AFILE_ATR_Header)) {
-			Util_fclose(f, sio_tmpbuf[diskno - 1]);
-			return FALSE;
-		}
+	if (ReadImage(diskno - 1, 0, (UBYTE *) &header, sizeof(struct AFILE_ATR_Header)) != sizeof(struct AFILE_ATR_Header)) {
+		FreeImage(diskno - 1);
+		fclose(f);
+		return FALSE;
+	}
+	if (compressed)
 		status = SIO_READ_ONLY;
 		/* XXX: status = b_open_readonly ? SIO_READ_ONLY : SIO_READ_WRITE; */
-		break;
-	case 0x1f:
-		if (header.magic2 == 0x8b) {
-			/* ATZ/ATR.GZ, XFZ/XFD.GZ */
-			fclose(f);
-			f = Util_tmpopen(sio_tmpbuf[diskno - 1]);
-			if (f == NULL)
-				return FALSE;
-			if (!CompFile_ExtractGZ(filename, f)) {
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				return FALSE;
-			}
-			Util_rewind(f);
-			if (fread(&header, 1, sizeof(struct AFILE_ATR_Header), f) != sizeof(struct AFILE_ATR_Header)) {
-				Util_fclose(f, sio_tmpbuf[diskno - 1]);
-				return FALSE;
-			}
-			status = SIO_READ_ONLY;
-			/* XXX: status = b_open_readonly ? SIO_READ_ONLY : SIO_READ_WRITE; */
-		}
-		break;
-	default:
-		break;
-	}
 
 	boot_sectors_type[diskno - 1] = BOOT_SECTORS_LOGICAL;
 
@@ -287,6 +531,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 
 		sectorsize[diskno - 1] = (header.secsizehi << 8) + header.secsizelo;
 		if (sectorsize[diskno - 1] != 128 && sectorsize[diskno - 1] != 256) {
+			FreeImage(diskno - 1);
 			Util_fclose(f, sio_tmpbuf[diskno - 1]);
 			return FALSE;
 		}
@@ -313,8 +558,8 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 				   a non-zero byte in bytes 0x190-0x30f of the ATR file */
 				UBYTE buffer[0x180];
 				int i;
-				fseek(f, 0x190, SEEK_SET);
-				if (fread(buffer, 1, 0x180, f) != 0x180) {
+				if (ReadImage(diskno - 1, 0x190, buffer, 0x180) != 0x180) {
+					FreeImage(diskno - 1);
 					Util_fclose(f, sio_tmpbuf[diskno - 1]);
 					return FALSE;
 				}
@@ -330,7 +575,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 	}
 	else if (header.magic1 == 'A' && header.magic2 == 'T' && header.seccountlo == '8' &&
 		 header.seccounthi == 'X') {
-		int file_length = Util_flen(f);
+		int file_length = image_size[diskno - 1];
 		vapi_additional_info_t *info;
 		vapi_file_header_t fileheader;
 		vapi_track_header_t trackheader;
@@ -341,8 +586,10 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		if (!b_open_readonly) {
 			fclose(f);
 			f = Util_fopen(filename, "rb", sio_tmpbuf[diskno - 1]);
-			if (f == NULL)
+			if (f == NULL) {
+				FreeImage(diskno - 1);
 				return FALSE;
+			}
 			status = SIO_READ_ONLY;
 		}
 #endif
@@ -350,14 +597,15 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		image_type[diskno - 1] = IMAGE_TYPE_VAPI;
 		sectorsize[diskno - 1] = 128;
 		sectorcount[diskno - 1] = 720;
-		fseek(f,0,SEEK_SET);
-		if (fread(&fileheader,1,sizeof(fileheader),f) != sizeof(fileheader)) {
+		if (ReadImage(diskno - 1, 0, (UBYTE *) &fileheader, sizeof(fileheader)) != sizeof(fileheader)) {
+			FreeImage(diskno - 1);
 			Util_fclose(f, sio_tmpbuf[diskno - 1]);
 			Log_print("VAPI: Bad File Header");
 			return(FALSE);
 			}
 		trackoffset = VAPI_32(fileheader.startdata);	
 		if (trackoffset > file_length) {
+			FreeImage(diskno - 1);
 			Util_fclose(f, sio_tmpbuf[diskno - 1]);
 			Log_print("VAPI: Bad Track Offset");
 			return(FALSE);
@@ -371,8 +619,8 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			ULONG next;
 			UWORD tracktype;
 
-			fseek(f,trackoffset,SEEK_SET);
-			if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
+			if (ReadImage(diskno - 1, trackoffset, (UBYTE *) &trackheader, sizeof(trackheader)) != sizeof(trackheader)) {
+				FreeImage(diskno - 1);
 				Util_fclose(f, sio_tmpbuf[diskno - 1]);
 				Log_print("VAPI: Bad Track Header");
 				return(FALSE);
@@ -402,10 +650,10 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			UWORD tracktype;
 			int j;
 
-			fseek(f,trackoffset,SEEK_SET);
-			if (fread(&trackheader,1,sizeof(trackheader),f) != sizeof(trackheader)) {
+			if (ReadImage(diskno - 1, trackoffset, (UBYTE *) &trackheader, sizeof(trackheader)) != sizeof(trackheader)) {
 				free(info->sectors);
 				free(info);
+				FreeImage(diskno - 1);
 				Util_fclose(f, sio_tmpbuf[diskno - 1]);
 				Log_print("VAPI: Bad Track Header while reading sectors");
 				return(FALSE);
@@ -422,14 +670,15 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 				if (seclistdata > file_length) {
 					free(info->sectors);
 					free(info);
+					FreeImage(diskno - 1);
 					Util_fclose(f, sio_tmpbuf[diskno - 1]);
 					Log_print("VAPI: Bad Sector List Offset");
 					return(FALSE);
 					}
-				fseek(f,seclistdata,SEEK_SET);
-				if (fread(&sectorlist,1,sizeof(sectorlist),f) != sizeof(sectorlist)) {
+				if (ReadImage(diskno - 1, seclistdata, (UBYTE *) &sectorlist, sizeof(sectorlist)) != sizeof(sectorlist)) {
 					free(info->sectors);
 					free(info);
+					FreeImage(diskno - 1);
 					Util_fclose(f, sio_tmpbuf[diskno - 1]);
 					Log_print("VAPI: Bad Sector List");
 					return(FALSE);
@@ -440,14 +689,17 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 				for (j=0;j<sectorcnt;j++) {
 					double percent_rot;
 
-					if (fread(&sectorheader,1,sizeof(sectorheader),f) != sizeof(sectorheader)) {
+					if (ReadImage(diskno - 1, seclistdata + sizeof(sectorlist) + j * sizeof(sectorheader),
+					              (UBYTE *) &sectorheader, sizeof(sectorheader)) != sizeof(sectorheader)) {
 						free(info->sectors);
 						free(info);
+						FreeImage(diskno - 1);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Bad Sector Header");
 						return(FALSE);
 						}
 					if (sectorheader.sectornum > 18)  {
+						FreeImage(diskno - 1);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Bad Sector Index: Track %d Sec Num %d Index %d",
 								trackheader.tracknum,j,sectorheader.sectornum);
@@ -463,6 +715,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 					if (sector->sec_count > MAX_VAPI_PHANTOM_SEC) {
 						free(info->sectors);
 						free(info);
+						FreeImage(diskno - 1);
 						Util_fclose(f, sio_tmpbuf[diskno - 1]);
 						Log_print("VAPI: Too many Phantom Sectors");
 						return(FALSE);
@@ -485,7 +738,7 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 		}			
 	}
 	else {
-		int file_length = Util_flen(f);
+		int file_length = image_size[diskno - 1];
 		/* check for PRO */
 		if ((file_length-16)%(128+12) == 0 &&
 				(header.magic1*256 + header.magic2 == (file_length-16)/(128+12)) &&
@@ -495,8 +748,10 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 			if (!b_open_readonly) {
 				fclose(f);
 				f = Util_fopen(filename, "rb", sio_tmpbuf[diskno - 1]);
-				if (f == NULL)
+				if (f == NULL) {
+					FreeImage(diskno - 1);
 					return FALSE;
+				}
 				status = SIO_READ_ONLY;
 			}
 			image_type[diskno - 1] = IMAGE_TYPE_PRO;
@@ -548,12 +803,19 @@ int SIO_Mount(int diskno, const char *filename, int b_open_readonly)
 	strcpy(SIO_filename[diskno - 1], filename);
 	SIO_drive_status[diskno - 1] = status;
 	disk[diskno - 1] = f;
+	if (status == SIO_READ_ONLY && image_entry[diskno - 1] == NULL) {
+		/* the image won't change, so it can be shared */
+		UseCached(diskno - 1, AddCached(image[diskno - 1], image_size[diskno - 1],
+			HashBytes(image[diskno - 1], image_size[diskno - 1]), image[diskno - 1], image_size[diskno - 1]));
+	}
 	return TRUE;
 }
 
 void SIO_Dismount(int diskno)
 {
 	if (disk[diskno - 1] != NULL) {
+		FlushImage(diskno - 1);
+		FreeImage(diskno - 1);
 		Util_fclose(disk[diskno - 1], sio_tmpbuf[diskno - 1]);
 		disk[diskno - 1] = NULL;
 		SIO_drive_status[diskno - 1] = SIO_NO_DISK;
@@ -578,10 +840,6 @@ void SIO_DisableDrive(int diskno)
 
 void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 {
-	int size;
-	ULONG offset;
-	int header_size = (image_type[unit] == IMAGE_TYPE_ATR ? 16 : 0);
-
 	if (BINLOAD_start_binloading) {
 		if (sz)
 			*sz = 128;
@@ -589,6 +847,14 @@ void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 			*ofs = 0;
 		return;
 	}
+	SectorPosition(unit, sector, sz, ofs);
+}
+
+static void SectorPosition(int unit, int sector, int *sz, ULONG *ofs)
+{
+	int size;
+	ULONG offset;
+	int header_size = (image_type[unit] == IMAGE_TYPE_ATR ? 16 : 0);
 
 	if (image_type[unit] == IMAGE_TYPE_PRO) {
 		size = 128;
@@ -629,15 +895,14 @@ void SIO_SizeOfSector(UBYTE unit, int sector, int *sz, ULONG *ofs)
 		*ofs = offset;
 }
 
-static int SeekSector(int unit, int sector)
+/* Returns the size of SECTOR and its position in the image in *OFFSET. */
+static int LocateSector(int unit, int sector, ULONG *offset)
 {
-	ULONG offset;
 	int size;
 
 	SIO_last_sector = sector;
 	snprintf(SIO_status, sizeof(SIO_status), "%d: %d", unit + 1, sector);
-	SIO_SizeOfSector((UBYTE) unit, sector, &size, &offset);
-	fseek(disk[unit], offset, SEEK_SET);
+	SIO_SizeOfSector((UBYTE) unit, sector, &size, offset);
 
 	return size;
 }
@@ -646,6 +911,7 @@ static int SeekSector(int unit, int sector)
 int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 {
 	int size;
+	ULONG offset;
 	if (BINLOAD_start_binloading)
 		return BINLOAD_LoaderStart(buffer);
 
@@ -658,15 +924,16 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		return 'E';
 	SIO_last_op = SIO_LAST_READ;
 	SIO_last_op_time = 1;
+	SIO_last_op_frame = Atari800_nframes;
 	SIO_last_drive = unit + 1;
 	/* FIXME: what sector size did the user expect? */
-	size = SeekSector(unit, sector);
+	size = LocateSector(unit, sector, &offset);
 	if (image_type[unit] == IMAGE_TYPE_PRO) {
 		pro_additional_info_t *info;
 		unsigned char *count;
 		info = (pro_additional_info_t *)additional_info[unit];
 		count = info->count;
-		if (fread(buffer, 1, 12, disk[unit]) < 12) {
+		if (ReadImage(unit, offset, buffer, 12) < 12) {
 			Log_print("Error in header of .pro image: sector:%d", sector);
 			return 'E';
 		}
@@ -684,17 +951,19 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 					Log_print("Error in .pro image: sector:%d dupnum:%d", sector, dupnum);
 					return 'E';
 				}
-				size = SeekSector(unit, sector);
+				size = LocateSector(unit, sector, &offset);
 				/* read sector header */
-				if (fread(buffer, 1, 12, disk[unit]) < 12) {
+				if (ReadImage(unit, offset, buffer, 12) < 12) {
 					Log_print("Error in header2 of .pro image: sector:%d dupnum:%d", sector, dupnum);
 					return 'E';
 				}
 			}
 		}
+		/* sector data follows the header */
+		offset += 12;
 		/* bad sector */
 		if (buffer[1] != 0xff) {
-			if (fread(buffer, 1, size, disk[unit]) < size) {
+			if (ReadImage(unit, offset, buffer, size) < size) {
 				Log_print("Error in bad sector of .pro image: sector:%d", sector);
 			}
 			io_success[unit] = sector;
@@ -786,13 +1055,13 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		if (secinfo->sec_count > 1)
 			Log_print("duplicate sector:%d dupnum:%d delay:%d",sector, secindex,info->vapi_delay_time);
 #endif
-		fseek(disk[unit],secinfo->sec_offset[secindex],SEEK_SET);
+		offset = secinfo->sec_offset[secindex];
 		info->sec_stat_buff[0] = 0x8 | ((secinfo->sec_status[secindex] == 0xFF) ? 0 : 0x04);
 		info->sec_stat_buff[1] = secinfo->sec_status[secindex];
 		info->sec_stat_buff[2] = 0xe0;
 		info->sec_stat_buff[3] = 0;
 		if (secinfo->sec_status[secindex] != 0xFF) {
-			if (fread(buffer, 1, size, disk[unit]) < size) {
+			if (ReadImage(unit, offset, buffer, size) < size) {
 				Log_print("error reading sector:%d", sector);
 			}
 			io_success[unit] = sector;
@@ -816,7 +1085,7 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 		Log_flushlog();
 #endif		
 	}
-	if (fread(buffer, 1, size, disk[unit]) < size) {
+	if (ReadImage(unit, offset, buffer, size) < size) {
 		Log_print("incomplete sector num:%d", sector);
 	}
 	io_success[unit] = 0;
@@ -826,6 +1095,7 @@ int SIO_ReadSector(int unit, int sector, UBYTE *buffer)
 int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 {
 	int size;
+	ULONG offset;
 	io_success[unit] = -1;
 	if (SIO_drive_status[unit] == SIO_OFF)
 		return 0;
@@ -835,6 +1105,7 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 		return 'E';
 	SIO_last_op = SIO_LAST_WRITE;
 	SIO_last_op_time = 1;
+	SIO_last_op_frame = Atari800_nframes;
 	SIO_last_drive = unit + 1;
 #ifdef VAPI_WRITE_ENABLE 	
  	if (image_type[unit] == IMAGE_TYPE_VAPI) {
@@ -854,9 +1125,11 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 			return 'E';
 		}
 		
-		size = SeekSector(unit, sector);
-		fseek(disk[unit],secinfo->sec_offset[0],SEEK_SET);
-		fwrite(buffer, 1, size, disk[unit]);
+		/* Located by SectorPosition() like any other sector (at
+		   sec_offset[0]), so that FlushImage() writes it back to the
+		   same position. */
+		size = LocateSector(unit, sector, &offset);
+		WriteImage(unit, sector, offset, buffer, size);
 		io_success[unit] = 0;
 		return 'C';
 #if 0		
@@ -877,8 +1150,8 @@ int SIO_WriteSector(int unit, int sector, const UBYTE *buffer)
 #endif			
 	} 
 #endif
-	size = SeekSector(unit, sector);
-	fwrite(buffer, 1, size, disk[unit]);
+	size = LocateSector(unit, sector, &offset);
+	WriteImage(unit, sector, offset, buffer, size);
 	io_success[unit] = 0;
 	return 'C';
 }
@@ -1066,8 +1339,9 @@ int SIO_DriveStatus(int unit, UBYTE *buffer)
 	/* .PRO contains status information in the sector header */
 	if (io_success[unit] != 0  && image_type[unit] == IMAGE_TYPE_PRO) {
 		int sector = io_success[unit];
-		SeekSector(unit, sector);
-		if (fread(buffer, 1, 4, disk[unit]) < 4) {
+		ULONG offset;
+		LocateSector(unit, sector, &offset);
+		if (ReadImage(unit, offset, buffer, 4) < 4) {
 			Log_print("SIO_DriveStatus: failed to read sector header");
 		}
 		return 'C';
@@ -1589,6 +1863,23 @@ void SIO_PutByte(int byte)
 	/* POKEY_DELAYED_SEROUT_IRQ = SIO_SEROUT_INTERVAL; */ /* already set in pokey.c */
 }
 
+/* Returns the number of scanlines between bytes of a data frame sent to
+   the computer. */
+static int DataByteInterval(void)
+{
+	/* at the speed the computer's POKEY is set to */
+	int interval = (SIO_SERIN_INTERVAL * POKEY_AUDF[POKEY_CHAN3] - 1) / 0x28 + 1;
+	int unit = CommandFrame[0] - '1';
+	if (SIO_accel_divisor >= 0 && unit >= 0 && unit < SIO_MAX_DRIVES
+	 && image_type[unit] != IMAGE_TYPE_VAPI && image_type[unit] != IMAGE_TYPE_PRO) {
+		/* 10 bits per byte, 2 * (AUDF + 7) CPU cycles per bit */
+		int accel = (20 * (SIO_accel_divisor + 7) + ANTIC_LINE_C - 1) / ANTIC_LINE_C;
+		if (accel < interval)
+			interval = accel;
+	}
+	return interval;
+}
+
 /* Get a byte from the floppy to the pokey. */
 int SIO_GetByte(void)
 {
@@ -1611,7 +1902,7 @@ int SIO_GetByte(void)
 			else {
 				/* set delay using the expected transfer speed */
 				POKEY_DELAYED_SERIN_IRQ = (DataIndex == 1) ? SIO_SERIN_INTERVAL
-					: ((SIO_SERIN_INTERVAL * POKEY_AUDF[POKEY_CHAN3] - 1) / 0x28 + 1);
+					: DataByteInterval();
 			}
 		}
 		else {
@@ -1683,6 +1974,9 @@ void SIO_StateSave(void)
 {
 	int i;
 
+	/* the state refers to the images by name, so they must be up to date */
+	SIO_Sync();
+
 	for (i = 0; i < 8; i++) {
 		StateSav_SaveINT((int *) &SIO_drive_status[i], 1);
 		StateSav_SaveFNAME(SIO_filename[i]);
@@ -24,11 +24,16 @@ extern char SIO_filename[SIO_MAX_DRIVES][FILENAME_MAX];
 #define SIO_LAST_WRITE 1
 extern int SIO_last_op;
 extern int SIO_last_op_time;
+/* Atari800_nframes at the last sector read or write */
+extern int SIO_last_op_frame;
 extern int SIO_last_drive; /* 1 .. 8 */
 extern int SIO_last_sector;
 
 int SIO_Mount(int diskno, const char *filename, int b_open_readonly);
 void SIO_Dismount(int diskno);
+/* Writes the sectors written since the last sync back to the image files.
+   Also done when a disk is dismounted. */
+void SIO_Sync(void);
 void SIO_DisableDrive(int diskno);
 int SIO_RotateDisks(void);
 void SIO_Handler(void);
@@ -39,6 +44,16 @@ void SIO_PutByte(int byte);
 int SIO_GetByte(void);
 int SIO_Initialise(int *argc, char *argv[]);
 void SIO_Exit(void);
+int SIO_ReadConfig(char *string, char *ptr);
+void SIO_WriteConfig(FILE *fp);
+
+/* POKEY divisor (AUDF3 value) of the speed at which the emulated drives
+   send data frames when the SIO patch is off, or -1 to send them at the
+   speed the computer's POKEY is set to, like a stock drive. Eg. 0x10 is
+   XF551 speed (39 kbit/s), 0x0a is US Doubler and Happy speed (52 kbit/s).
+   ATX and PRO images are always read at stock speed, as copy protections
+   measure their timing. */
+extern int SIO_accel_divisor;
 
 /* Some defines about the serial I/O timing. Currently fixed! */
 #define SIO_XMTDONE_INTERVAL  15
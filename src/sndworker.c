@@ -0,0 +1,142 @@
+/*
+ * sndworker.c - worker threads for sound synthesis
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+#include "config.h"
+#include <pthread.h>
+
+#include "atari.h"
+#include "log.h"
+#include "sndworker.h"
+
+/* The calling thread generates the first POKEY itself, so two workers are
+   enough for the second POKEY and the Votrax. */
+#define MAX_WORKERS 2
+
+typedef struct {
+	pthread_t thread;
+	pthread_mutex_t mutex;
+	pthread_cond_t cond; /* signalled when func changes */
+	void (*func)(void *); /* job being run, NULL when idle */
+	void *arg;
+	int quit;
+	int running; /* thread is created */
+	int busy; /* job was started and not waited for; used by the caller only */
+} worker_t;
+
+static worker_t workers[MAX_WORKERS];
+
+/* Set if a thread couldn't be created; all jobs are then run at once. */
+static int failed = FALSE;
+
+static void *WorkerThread(void *data)
+{
+	worker_t *w = (worker_t *) data;
+	pthread_mutex_lock(&w->mutex);
+	for (;;) {
+		void (*func)(void *);
+		while (w->func == NULL && !w->quit)
+			pthread_cond_wait(&w->cond, &w->mutex);
+		if (w->quit)
+			break;
+		func = w->func;
+		pthread_mutex_unlock(&w->mutex);
+		(*func)(w->arg);
+		pthread_mutex_lock(&w->mutex);
+		w->func = NULL;
+		pthread_cond_signal(&w->cond);
+	}
+	pthread_mutex_unlock(&w->mutex);
+	return NULL;
+}
+
+static int StartThread(worker_t *w)
+{
+	pthread_mutex_init(&w->mutex, NULL);
+	pthread_cond_init(&w->cond, NULL);
+	w->func = NULL;
+	w->quit = FALSE;
+	if (pthread_create(&w->thread, NULL, &WorkerThread, w) != 0) {
+		Log_print("Cannot create sound worker thread, generating sound in one thread");
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->mutex);
+		failed = TRUE;
+		return FALSE;
+	}
+	w->running = TRUE;
+	return TRUE;
+}
+
+int SNDWORKER_Start(void (*func)(void *), void *arg)
+{
+	int i;
+	if (!failed) {
+		for (i = 0; i < MAX_WORKERS; i++) {
+			worker_t *w = &workers[i];
+			if (w->busy)
+				continue;
+			if (!w->running && !StartThread(w))
+				break;
+			w->busy = TRUE;
+			pthread_mutex_lock(&w->mutex);
+			w->func = func;
+			w->arg = arg;
+			pthread_cond_signal(&w->cond);
+			pthread_mutex_unlock(&w->mutex);
+			return i;
+		}
+	}
+	(*func)(arg);
+	return -1;
+}
+
+void SNDWORKER_Wait(int job)
+{
+	worker_t *w;
+	if (job < 0)
+		return;
+	w = &workers[job];
+	pthread_mutex_lock(&w->mutex);
+	while (w->func != NULL)
+		pthread_cond_wait(&w->cond, &w->mutex);
+	pthread_mutex_unlock(&w->mutex);
+	w->busy = FALSE;
+}
+
+void SNDWORKER_Exit(void)
+{
+	int i;
+	for (i = 0; i < MAX_WORKERS; i++) {
+		worker_t *w = &workers[i];
+		if (!w->running)
+			continue;
+		SNDWORKER_Wait(i);
+		pthread_mutex_lock(&w->mutex);
+		w->quit = TRUE;
+		pthread_cond_signal(&w->cond);
+		pthread_mutex_unlock(&w->mutex);
+		pthread_join(w->thread, NULL);
+		pthread_cond_destroy(&w->cond);
+		pthread_mutex_destroy(&w->mutex);
+		w->running = FALSE;
+	}
+}
@@ -0,0 +1,20 @@
+#ifndef SNDWORKER_H_
+#define SNDWORKER_H_
+
+/* A small pool of worker threads for sound synthesis, used to generate
+   the streams of the two POKEYs and the Votrax in parallel.
+
+   SNDWORKER_Start runs FUNC(ARG) on an idle worker thread and returns a
+   job number to pass to SNDWORKER_Wait. If no worker is available, FUNC
+   is run at once in the calling thread and -1 is returned. Jobs must be
+   started and waited for in the same thread. */
+int SNDWORKER_Start(void (*func)(void *), void *arg);
+
+/* Waits until the job returned by SNDWORKER_Start has finished. Does
+   nothing for job -1. */
+void SNDWORKER_Wait(int job);
+
+/* Stops all worker threads. They are started again when needed. */
+void SNDWORKER_Exit(void);
+
+#endif /* SNDWORKER_H_ */
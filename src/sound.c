@@ -22,6 +22,7 @@
  * 51 Franklin Street, Fifth Floor, Boston, MA 02110-1301 USA.
  */
 
+#include <math.h>
 #include <stdlib.h>
 #include <stdio.h>
 
@@ -29,10 +30,20 @@
 
 #include "atari.h"
 #include "log.h"
+#include "mzpokeysnd.h"
 #include "platform.h"
 #include "pokeysnd.h"
+#ifdef SOUND_THREADS
+#include "sndworker.h"
+#endif
 #include "util.h"
 
+#if defined(SYNCHRONIZED_SOUND) && defined(SOUND_CALLBACK) && defined(HAVE_STDATOMIC_H) && !defined(__STDC_NO_ATOMICS__)
+/* sync_buffer is shared with Sound_Callback without locking. */
+#define SYNC_LOCK_FREE
+#include <stdatomic.h>
+#endif
+
 #define DEBUG 0
 
 int Sound_enabled = 1;
@@ -54,15 +65,29 @@ static unsigned int process_buffer_size;
 #endif /* !SOUND_CALLBACK */
 
 #ifdef SYNCHRONIZED_SOUND
+#ifdef SYNC_LOCK_FREE
+typedef atomic_uint sync_shared_t;
+#define SYNC_LOAD(var) atomic_load_explicit(&(var), memory_order_acquire)
+#define SYNC_STORE(var, val) atomic_store_explicit(&(var), (val), memory_order_release)
+#define SYNC_LOCK()
+#define SYNC_UNLOCK()
+#else /* !SYNC_LOCK_FREE */
+typedef unsigned int sync_shared_t;
+#define SYNC_LOAD(var) (var)
+#define SYNC_STORE(var, val) ((var) = (val))
+#define SYNC_LOCK() PLATFORM_SoundLock()
+#define SYNC_UNLOCK() PLATFORM_SoundUnlock()
+#endif /* !SYNC_LOCK_FREE */
+
 static UBYTE *sync_buffer = NULL;
 static unsigned int sync_buffer_size;
-/* Two invariants are held:
-   a) 0 <= sync_read_pos < sync_buffer_size
-   b) sync_read_pos <= sync_write_pos <= sync_buffer_size + sync_read_pos
-   sync_write_pos may be >= sync_buffer_size. In such case the actual write
-   position is sync_write_pos % sync_buffer_size. */
-static unsigned int sync_write_pos;
-static unsigned int sync_read_pos;
+/* sync_buffer is a ring written by UpdateSyncBuffer and read by FillBuffer.
+   Both positions are in the range 0 .. sync_buffer_size-1, and each of them
+   is only changed by its own side. The ring never holds more than
+   sync_buffer_size - bytes_per_frame bytes, so equal positions mean that
+   it is empty. */
+static sync_shared_t sync_write_pos;
+static sync_shared_t sync_read_pos;
 
 unsigned int Sound_latency = 20;
 /* Cumulative audio difference. */
@@ -74,9 +99,25 @@ static unsigned int sync_min_fill;
 static unsigned int sync_max_fill;
 #ifdef SOUND_CALLBACK
 #endif /* SOUND_CALLBACK */
-/* Time of last write of sudio to output device (either by Sound_Callback or
-   WriteOut). */
-double last_audio_write_time;
+/* Time of last write of audio to output device (either by Sound_Callback or
+   WriteOut), in microseconds modulo 2^32. */
+static sync_shared_t last_audio_write_usec;
+
+static unsigned int TimeUsec(void)
+{
+	return (unsigned int) fmod(Util_time() * 1e6, 4294967296.0);
+}
+
+static void SetAudioWriteTime(void)
+{
+	SYNC_STORE(last_audio_write_usec, TimeUsec());
+}
+
+/* Returns the number of bytes held in sync_buffer. */
+static unsigned int SyncFill(unsigned int write_pos, unsigned int read_pos)
+{
+	return write_pos >= read_pos ? write_pos - read_pos : write_pos + sync_buffer_size - read_pos;
+}
 #endif /* SYNCHRONIZED_SOUND */
 
 enum { MAX_SAMPLE_SIZE = 2, /* for 16-bit */
@@ -159,6 +200,15 @@ int Sound_Initialise(int *argc, char *argv[])
 			Sound_desired.sample_size = 2;
 		else if (strcmp(argv[i], "-audio8") == 0)
 			Sound_desired.sample_size = 1;
+		else if (strcmp(argv[i], "-pokey-fixed") == 0)
+			MZPOKEYSND_fixed_point = TRUE;
+		else if (strcmp(argv[i], "-pokey-float") == 0)
+			MZPOKEYSND_fixed_point = FALSE;
+		else if (strcmp(argv[i], "-pokey-filter-cache") == 0) {
+			if (i_a)
+				Util_strlcpy(MZPOKEYSND_filter_cache_dir, argv[++i], FILENAME_MAX);
+			else a_m = TRUE;
+		}
 		else if (strcmp(argv[i], "snd-buflen") == 0) {
 			if (i_a) {
 				int val = Util_sscandec(argv[++i]);
@@ -184,6 +234,10 @@ int Sound_Initialise(int *argc, char *argv[])
 				Log_print("\t-volume <0 .. 100>   Set sound output volume");
 				Log_print("\t-audio16             Set sound output format to 16-bit");
 				Log_print("\t-audio8              Set sound output format to 8-bit");
+				Log_print("\t-pokey-fixed         Use fixed point arithmetic in the new POKEY resampler");
+				Log_print("\t-pokey-float         Use floating point arithmetic in the new POKEY resampler");
+				Log_print("\t-pokey-filter-cache <dir>");
+				Log_print("\t                     Store computed POKEY resampling filters in <dir>");
 				Log_print("\t-snd-buflen <ms>     Set length of the hardware sound buffer in milliseconds");
 #ifdef SYNCHRONIZED_SOUND
 				Log_print("\t-snddelay <ms>       Set sound latency in milliseconds");
@@ -273,6 +327,9 @@ void Sound_Exit(void)
 	if (Sound_enabled) {
 		PLATFORM_SoundExit();
 		Sound_enabled = FALSE;
+#ifdef SOUND_THREADS
+		SNDWORKER_Exit();
+#endif
 #ifndef SOUND_CALLBACK
 		free(process_buffer);
 		process_buffer = NULL;
@@ -300,7 +357,7 @@ void Sound_Continue(void)
 #ifdef SYNCHRONIZED_SOUND
 /*		sync_write_pos = sync_read_pos + sync_min_fill;
 		avg_fill = sync_min_fill;*/
-		last_audio_write_time = Util_time();
+		SetAudioWriteTime();
 #endif /* SYNCHRONIZED_SOUND */
 		PLATFORM_SoundContinue();
 		paused = FALSE;
@@ -314,29 +371,29 @@ static void FillBuffer(UBYTE *buffer, unsigned int size)
 	unsigned int new_read_pos;
 	static UBYTE last_frame[MAX_FRAME_SIZE];
 	unsigned int bytes_per_frame = Sound_out.channels * Sound_out.sample_size;
-	unsigned int to_write = sync_write_pos - sync_read_pos;
+	unsigned int read_pos = SYNC_LOAD(sync_read_pos);
+	unsigned int to_write = SyncFill(SYNC_LOAD(sync_write_pos), read_pos);
 
 	if (to_write > 0) {
 		if (to_write > size)
 			to_write = size;
 
-		new_read_pos = sync_read_pos + to_write;
+		new_read_pos = read_pos + to_write;
 
 		if (new_read_pos <= sync_buffer_size)
 			/* no wrap */
-			memcpy(buffer, sync_buffer + sync_read_pos, to_write);
+			memcpy(buffer, sync_buffer + read_pos, to_write);
 		else {
 			/* wraps */
-			unsigned int first_part_size = sync_buffer_size - sync_read_pos;
-			memcpy(buffer, sync_buffer + sync_read_pos, first_part_size);
+			unsigned int first_part_size = sync_buffer_size - read_pos;
+			memcpy(buffer, sync_buffer + read_pos, first_part_size);
 			memcpy(buffer + first_part_size, sync_buffer, to_write - first_part_size);
 		}
 
-		sync_read_pos = new_read_pos;
-		if (sync_read_pos > sync_buffer_size) {
-			sync_read_pos -= sync_buffer_size;
-			sync_write_pos -= sync_buffer_size;
-		}
+		if (new_read_pos >= sync_buffer_size)
+			new_read_pos -= sync_buffer_size;
+		/* Publish the position only after the data has been copied. */
+		SYNC_STORE(sync_read_pos, new_read_pos);
 		/* Save the last frame as we may need it to fill underflow. */
 		memcpy(last_frame, buffer + to_write - bytes_per_frame, bytes_per_frame);
 	}
@@ -364,12 +421,12 @@ void Sound_Callback(UBYTE *buffer, unsigned int size)
 {
 #if DEBUG >= 2
 		Log_print("Callback: fill %u, needed %u",
-		          (sync_write_pos - sync_read_pos) / Sound_out.channels / Sound_out.sample_size,
+		          SyncFill(SYNC_LOAD(sync_write_pos), SYNC_LOAD(sync_read_pos)) / Sound_out.channels / Sound_out.sample_size,
 		          size / Sound_out.channels / Sound_out.sample_size);
 #endif
 	FillBuffer(buffer, size);
 #ifdef SYNCHRONIZED_SOUND
-	last_audio_write_time = Util_time();
+	SetAudioWriteTime();
 #endif /* SYNCHRONIZED_SOUND */
 }
 #else /* !SOUND_CALLBACK */
@@ -381,7 +438,7 @@ static void WriteOut(void)
 	if (avail > 0) {
 #if DEBUG >= 2
 		Log_print("WriteOut: fill %u, needed %u",
-		          (sync_write_pos - sync_read_pos) / Sound_out.channels / Sound_out.sample_size,
+		          SyncFill(sync_write_pos, sync_read_pos) / Sound_out.channels / Sound_out.sample_size,
 		          avail / Sound_out.channels / Sound_out.sample_size);
 #endif
 		/* On some platforms (eg. NestedVM) avail may be larger than process_buffer_size. */
@@ -392,7 +449,7 @@ static void WriteOut(void)
 			avail -= len;
 		} while (avail > 0);
 #ifdef SYNCHRONIZED_SOUND
-		last_audio_write_time = Util_time();
+		SetAudioWriteTime();
 #endif /* SYNCHRONIZED_SOUND */
 	}
 }
@@ -404,24 +461,34 @@ static void UpdateSyncBuffer(void)
 	unsigned int bytes_written;
 	unsigned int samples_written;
 	unsigned int fill;
+	unsigned int write_pos;
 	unsigned int new_write_pos;
+	unsigned int bytes_per_frame = Sound_out.channels * Sound_out.sample_size;
+	/* The ring is full at this level, see sync_write_pos. */
+	unsigned int capacity = sync_buffer_size - bytes_per_frame;
 
-	PLATFORM_SoundLock();
+	SYNC_LOCK();
+	write_pos = SYNC_LOAD(sync_write_pos);
 	/* Current fill of the audio buffer. */
-	fill = sync_write_pos - sync_read_pos;
+	fill = SyncFill(write_pos, SYNC_LOAD(sync_read_pos));
 
-	/* Update sync_est_fill. */
+	/* Update sync_est_fill. The output device has been draining the buffer
+	   since the last write to it, but by no more than one hardware buffer,
+	   as the next write would have happened otherwise. */
 	{
-		unsigned int est_gap;
-		est_gap = (Util_time() - last_audio_write_time)*Sound_out.freq*Sound_out.channels*Sound_out.sample_size;
+		unsigned int max_gap = Sound_out.buffer_frames * bytes_per_frame;
+		unsigned int gap_usec = TimeUsec() - SYNC_LOAD(last_audio_write_usec);
+		double est_gap = gap_usec * 1e-6 * Sound_out.freq * bytes_per_frame;
+		if (est_gap > max_gap)
+			est_gap = max_gap;
 		if (fill < est_gap)
 			sync_est_fill = 0;
 		else
-			sync_est_fill = fill - est_gap;
+			sync_est_fill = fill - (unsigned int) est_gap;
 	}
 
 	if (Atari800_turbo && sync_est_fill > sync_max_fill) {
-		PLATFORM_SoundUnlock();
+		SYNC_UNLOCK();
 		return;
 	}
 
@@ -430,52 +497,53 @@ static void UpdateSyncBuffer(void)
 	bytes_written = Sound_out.sample_size * samples_written;
 
 	/* if there isn't enough room... */
-	if (bytes_written > sync_buffer_size - fill) {
+	if (bytes_written > capacity - fill) {
 		/* Overflow of sync_buffer. */
 #if DEBUG
 		Log_print("Sound buffer overflow: free %d, needed %d",
-				  (sync_buffer_size - fill)/Sound_out.channels/Sound_out.sample_size,
+				  (capacity - fill)/Sound_out.channels/Sound_out.sample_size,
 				  bytes_written/Sound_out.channels/Sound_out.sample_size);
 #endif
 		/* Wait until hardware buffer can be filled, or wait until callback
 		   makes place in the buffer. */
 		do {
-			PLATFORM_SoundUnlock();
+			SYNC_UNLOCK();
 #ifndef __MINT__	/* this does more harm than good on Atari */
 			/* Sleep for the duration of one full HW buffer. */
 			Util_sleep((double)Sound_out.buffer_frames / Sound_out.freq);
 #endif
-			PLATFORM_SoundLock();
+			SYNC_LOCK();
 #ifndef SOUND_CALLBACK
 			WriteOut(); /* Write to audio buffer as much as possible. */
 #endif /* SOUND_CALLBACK */
-			fill = sync_write_pos - sync_read_pos;
-		} while (bytes_written > sync_buffer_size - fill);
+			fill = SyncFill(write_pos, SYNC_LOAD(sync_read_pos));
+		} while (bytes_written > capacity - fill);
 	}
-	/* Now bytes_written <= audio_buffer_size + dsp_read_pos - dsp_write_pos) */
+	/* Now bytes_written <= capacity - fill */
 
 #if DEBUG >= 2
-	Log_print("UpdateSyncBuffer: est_gap: %f, fill %u, write %u",
-			(Util_time() - last_audio_write_time)*Sound_out.freq,
+	Log_print("UpdateSyncBuffer: est_fill: %u, fill %u, write %u",
+	          sync_est_fill / Sound_out.channels/Sound_out.sample_size,
 	          fill / Sound_out.channels/Sound_out.sample_size,
 	          bytes_written / Sound_out.channels/Sound_out.sample_size);
 #endif
 	/* now we copy the data into the buffer and adjust the positions */
-	new_write_pos = sync_write_pos + bytes_written;
-	if (new_write_pos/sync_buffer_size == sync_write_pos/sync_buffer_size)
+	new_write_pos = write_pos + bytes_written;
+	if (new_write_pos <= sync_buffer_size)
 		/* no wrap */
-		memcpy(sync_buffer + sync_write_pos%sync_buffer_size, POKEYSND_process_buffer, bytes_written);
+		memcpy(sync_buffer + write_pos, POKEYSND_process_buffer, bytes_written);
 	else {
 		/* wraps */
-		int first_part_size = sync_buffer_size - sync_write_pos%sync_buffer_size;
-		memcpy(sync_buffer + sync_write_pos%sync_buffer_size, POKEYSND_process_buffer, first_part_size);
+		unsigned int first_part_size = sync_buffer_size - write_pos;
+		memcpy(sync_buffer + write_pos, POKEYSND_process_buffer, first_part_size);
 		memcpy(sync_buffer, POKEYSND_process_buffer + first_part_size, bytes_written - first_part_size);
 	}
+	if (new_write_pos >= sync_buffer_size)
+		new_write_pos -= sync_buffer_size;
 
-	sync_write_pos = new_write_pos;
-	if (sync_write_pos > sync_read_pos + sync_buffer_size)
-		sync_write_pos -= sync_buffer_size;
-	PLATFORM_SoundUnlock();
+	/* Publish the position only after the data has been copied. */
+	SYNC_STORE(sync_write_pos, new_write_pos);
+	SYNC_UNLOCK();
 }
 #endif /* SYNCHRONIZED_SOUND */
 
@@ -500,13 +568,16 @@ void Sound_SetLatency(unsigned int latency)
 		enum { SYNC_BUFFER_FRAGS = 5 };
 		unsigned int bytes_per_frame = Sound_out.channels * Sound_out.sample_size;
 		unsigned int latency_frames = Sound_out.freq*Sound_latency/1000;
+		/* The callback is not running while the lock is held, even if the
+		   ring is otherwise accessed without locking. */
 		PLATFORM_SoundLock();
-		sync_buffer_size = (latency_frames + SYNC_BUFFER_FRAGS*Sound_out.buffer_frames) * bytes_per_frame;
+		/* One extra frame, as a full ring would look empty. */
+		sync_buffer_size = (latency_frames + SYNC_BUFFER_FRAGS*Sound_out.buffer_frames + 1) * bytes_per_frame;
 		sync_min_fill = latency_frames * bytes_per_frame;
 		sync_max_fill = sync_min_fill + Sound_out.buffer_frames * bytes_per_frame;
 		avg_fill = sync_min_fill;
-		sync_read_pos = 0;
-		sync_write_pos = sync_min_fill;
+		SYNC_STORE(sync_read_pos, 0);
+		SYNC_STORE(sync_write_pos, sync_min_fill);
 		free(sync_buffer);
 		sync_buffer = Util_malloc(sync_buffer_size);
 		memset(sync_buffer, 0, sync_buffer_size);
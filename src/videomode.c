@@ -534,6 +534,9 @@ static int UpdateVideoFullscreen(void)
 	VIDEOMODE_resolution_t res;
 	if (res_for_mode == NULL)
 		return FALSE;
+#if SUPPORTS_PLATFORM_DISPLAYCHANGE
+	PLATFORM_BeforeDisplayChange();
+#endif
 
 	res = *res_for_mode;
 	if (rotate)
@@ -564,6 +567,9 @@ static int UpdateVideoWindowed(int window_resized)
 	VIDEOMODE_resolution_t *max_res;
 	int maximised = PLATFORM_WindowMaximised();
 
+#if SUPPORTS_PLATFORM_DISPLAYCHANGE
+	PLATFORM_BeforeDisplayChange();
+#endif
 	if (rotate)
 		RotateResolution(&res);
 
@@ -44,7 +44,9 @@ static double ratio;
 static int bit16;
 #define VTRX_BLOCK_SIZE 1024
 SWORD *temp_votrax_buffer = NULL;
-SWORD *votrax_buffer = NULL;
+SWORD *votrax_buffer = NULL; /* output of VOTRAXSND_Generate */
+static int votrax_buffer_size = 0;
+static int votrax_buffer_len = 0; /* samples waiting for VOTRAXSND_Mix */
 int VOTRAXSND_busy = FALSE;
 static int votrax_sync_samples;
 static int dsprate;
@@ -78,7 +80,7 @@ static void VOTRAXSND_busy_callback_async(int busy_status)
 	/* do nothing */
 }
 
-static int votraxsnd_enabled(void)
+int VOTRAXSND_Enabled(void)
 {
 	if (
 #ifdef VOICEBOX
@@ -100,7 +102,7 @@ void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16)
 	bit16 = b16;
 	dsprate = playback_freq;
 	num_pokeys = n_pokeys;
-	if (!votraxsnd_enabled()) return;
+	if (!VOTRAXSND_Enabled()) return;
 	if (num_pokeys != 1 && num_pokeys != 2) {
 		Log_print("VOTRAXSND_Init: cannot handle num_pokeys=%d", num_pokeys);
 #ifdef PBI_XLD
@@ -125,7 +127,9 @@ void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16)
 	free(temp_votrax_buffer);
 	temp_votrax_buffer = (SWORD *)Util_malloc(temp_votrax_buffer_size*sizeof(SWORD));
 	free(votrax_buffer);
-	votrax_buffer = (SWORD *)Util_malloc(VTRX_BLOCK_SIZE*sizeof(SWORD));
+	votrax_buffer = NULL;
+	votrax_buffer_size = 0;
+	votrax_buffer_len = 0;
 
 	VOTRAXSND_busy = FALSE;
 	votrax_sync_samples = 0;
@@ -238,7 +242,7 @@ static void mix8(UBYTE *dst, SWORD *src, int sndn, int volume)
 
 void VOTRAXSND_Frame(void)
 {
-	if (!votraxsnd_enabled()) return;
+	if (!VOTRAXSND_Enabled()) return;
 #ifdef VOICEBOX
 	if (VOICEBOX_enabled && VOICEBOX_ii) {
 		double factor = (VOICEBOX_BASEAUDF+1.0)/(POKEY_AUDF[3]+1.0);
@@ -256,22 +260,40 @@ void VOTRAXSND_Frame(void)
 	}
 }
 
-void VOTRAXSND_Process(void *sndbuffer, int sndn)
+void VOTRAXSND_Generate(int sndn)
 {
-	if (!votraxsnd_enabled()) return;
+	votrax_buffer_len = 0;
+	if (!VOTRAXSND_Enabled()) return;
 
 	if(votrax_written) {
 		votrax_written = FALSE;
 		Votrax_PutByte(votrax_written_byte);
 	}
 	sndn /= num_pokeys;
-	while (sndn > 0) {
-		int amount = ((sndn > VTRX_BLOCK_SIZE) ? VTRX_BLOCK_SIZE : sndn);
-		votrax_process(votrax_buffer, amount, temp_votrax_buffer);
-		if (bit16) mix((SWORD *)sndbuffer, votrax_buffer, amount, POKEYSND_volume >> 3);
-		else mix8((UBYTE *)sndbuffer, votrax_buffer, amount, POKEYSND_volume >> 3);
-		sndbuffer = (char *) sndbuffer + VTRX_BLOCK_SIZE*(bit16 ? 2 : 1)*((num_pokeys == 2) ? 2: 1);
-		sndn -= VTRX_BLOCK_SIZE;
+	if (sndn > votrax_buffer_size) {
+		votrax_buffer = (SWORD *)Util_realloc(votrax_buffer, sndn*sizeof(SWORD));
+		votrax_buffer_size = sndn;
+	}
+	while (votrax_buffer_len < sndn) {
+		int amount = sndn - votrax_buffer_len;
+		if (amount > VTRX_BLOCK_SIZE)
+			amount = VTRX_BLOCK_SIZE;
+		votrax_process(votrax_buffer + votrax_buffer_len, amount, temp_votrax_buffer);
+		votrax_buffer_len += amount;
 	}
 }
 
+void VOTRAXSND_Mix(void *sndbuffer)
+{
+	if (votrax_buffer_len == 0) return;
+	if (bit16) mix((SWORD *)sndbuffer, votrax_buffer, votrax_buffer_len, POKEYSND_volume >> 3);
+	else mix8((UBYTE *)sndbuffer, votrax_buffer, votrax_buffer_len, POKEYSND_volume >> 3);
+	votrax_buffer_len = 0;
+}
+
+void VOTRAXSND_Process(void *sndbuffer, int sndn)
+{
+	VOTRAXSND_Generate(sndn);
+	VOTRAXSND_Mix(sndbuffer);
+}
+
@@ -8,6 +8,13 @@ void VOTRAXSND_PutByte(UBYTE byte);
 void VOTRAXSND_Init(int playback_freq, int n_pokeys, int b16);
 void VOTRAXSND_Frame(void);
 void VOTRAXSND_Process(void *sndbuffer, int sndn);
+/* VOTRAXSND_Process split in two: VOTRAXSND_Generate synthesises the voice
+   for SNDN output samples and may run on another thread than the POKEY
+   sound; VOTRAXSND_Mix then adds it to SNDBUFFER. */
+void VOTRAXSND_Generate(int sndn);
+void VOTRAXSND_Mix(void *sndbuffer);
+/* Returns TRUE if any Votrax device is enabled. */
+int VOTRAXSND_Enabled(void);
 extern int VOTRAXSND_busy;
 void VOTRAXSND_Reinit(void);
 void VOTRAXSND_ModifyRatio(double factor);
@@ -0,0 +1,585 @@
+/*
+ * imgscan.c - classifies a library of Atari images and writes a manifest
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Walks directories of disk, tape, cartridge and executable images and
+   writes one JSON or CSV record per file: its type as detected by the
+   emulator, CRC32, and what can be told without running it - cartridge
+   type, disk geometry, executable segments, and the machine and BASIC
+   setting it probably needs. Files are examined by several threads.
+
+   Build by linking with the emulator's objects, eg.:
+   cc -I../src imgscan.c ../src/libatari800.a -lpthread
+   or run "make imgscan" in a libatari800 build. */
+
+#include "config.h"
+#include <dirent.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "atari.h"
+#include "afile.h"
+#include "cartridge.h"
+#include "compfile.h"
+#include "crc32.h"
+#include "log.h"
+#include "util.h"
+
+#define MAX_THREADS 64
+
+typedef struct {
+	char *path;
+	long size;
+	int type; /* AFILE_* */
+	ULONG crc; /* of the file */
+	ULONG data_crc; /* of the uncompressed contents */
+	int cart_type; /* CARTRIDGE_UNKNOWN if several types match a ROM */
+	int cart_candidates; /* number of cartridge types that match a ROM */
+	int checksum_ok; /* CART header checksum matches the data */
+	int sectors; /* disk images */
+	int sector_size;
+	int segments; /* executables */
+	int load_start;
+	int load_end;
+	const char *machine; /* "5200", "xl" (needs an XL/XE), "any" or "" */
+	const char *basic; /* "on", "off" or "" */
+	const char *error; /* NULL if the file was read correctly */
+} entry_t;
+
+static entry_t *entries = NULL;
+static int num_entries = 0;
+static int max_entries = 0;
+
+/* Next entry to examine, shared by the threads */
+static int next_entry = 0;
+static pthread_mutex_t next_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* The emulator's Log_print() is not thread-safe and writes to standard
+   output, where the manifest may go. It is replaced by a version that
+   writes whole lines to standard error, one thread at a time. */
+static pthread_mutex_t log_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+#ifdef BUFFERED_LOG
+char Log_buffer[Log_BUFFER_SIZE];
+#endif
+
+void Log_print(const char *format, ...)
+{
+	va_list args;
+	pthread_mutex_lock(&log_mutex);
+	va_start(args, format);
+	vfprintf(stderr, format, args);
+	va_end(args);
+	fputc('\n', stderr);
+	pthread_mutex_unlock(&log_mutex);
+}
+
+void Log_flushlog(void)
+{
+}
+
+static const char *TypeName(int type)
+{
+	switch (type) {
+	case AFILE_ATR: return "atr";
+	case AFILE_XFD: return "xfd";
+	case AFILE_ATR_GZ: return "atr.gz";
+	case AFILE_XFD_GZ: return "xfd.gz";
+	case AFILE_DCM: return "dcm";
+	case AFILE_XEX: return "xex";
+	case AFILE_BAS: return "bas";
+	case AFILE_LST: return "lst";
+	case AFILE_CART: return "car";
+	case AFILE_ROM: return "rom";
+	case AFILE_CAS: return "cas";
+	case AFILE_BOOT_TAPE: return "boottape";
+	case AFILE_STATE: return "state";
+	case AFILE_STATE_GZ: return "state.gz";
+	case AFILE_PRO: return "pro";
+	case AFILE_ATX: return "atx";
+	default: return "unknown";
+	}
+}
+
+static int Is5200(int cart_type)
+{
+	return strstr(CARTRIDGES[cart_type].description, "5200") != NULL;
+}
+
+static void AddEntry(const char *path, long size)
+{
+	entry_t *e;
+	if (num_entries >= max_entries) {
+		max_entries = max_entries == 0 ? 1024 : max_entries * 2;
+		entries = (entry_t *) realloc(entries, max_entries * sizeof(entry_t));
+		if (entries == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			exit(3);
+		}
+	}
+	e = &entries[num_entries++];
+	memset(e, 0, sizeof(entry_t));
+	e->path = strdup(path);
+	e->size = size;
+	e->cart_type = CARTRIDGE_NONE;
+	e->machine = "";
+	e->basic = "";
+}
+
+/* Adds PATH, or all files below it if it is a directory. */
+static void Walk(const char *path)
+{
+	struct stat st;
+	DIR *dir;
+	struct dirent *de;
+	if (stat(path, &st) != 0) {
+		perror(path);
+		return;
+	}
+	if (!S_ISDIR(st.st_mode)) {
+		if (S_ISREG(st.st_mode))
+			AddEntry(path, (long) st.st_size);
+		return;
+	}
+	if ((dir = opendir(path)) == NULL) {
+		perror(path);
+		return;
+	}
+	while ((de = readdir(dir)) != NULL) {
+		char *sub;
+		if (de->d_name[0] == '.')
+			continue;
+		sub = (char *) malloc(strlen(path) + strlen(de->d_name) + 2);
+		if (sub == NULL)
+			break;
+		sprintf(sub, "%s/%s", path, de->d_name);
+		Walk(sub);
+		free(sub);
+	}
+	closedir(dir);
+}
+
+static int ComparePaths(const void *a, const void *b)
+{
+	return strcmp(((const entry_t *) a)->path, ((const entry_t *) b)->path);
+}
+
+/* Reads a raw ROM image of LEN bytes: lists the cartridge types of its size,
+   like CARTRIDGE_Insert() does. */
+static void ExamineRom(entry_t *e, int len)
+{
+	int type;
+	int a8 = 0;
+	int vcs = 0;
+	e->cart_type = CARTRIDGE_NONE;
+	if ((len & 0x3ff) != 0)
+		return;
+	for (type = 1; type < CARTRIDGE_TYPE_COUNT; type++)
+		if (CARTRIDGES[type].kb == len >> 10) {
+			e->cart_candidates++;
+			e->cart_type = e->cart_candidates == 1 ? type : CARTRIDGE_UNKNOWN;
+			if (Is5200(type))
+				vcs++;
+			else
+				a8++;
+		}
+	e->machine = a8 == 0 ? (vcs == 0 ? "" : "5200") : (vcs == 0 ? "any" : "");
+}
+
+static void ExamineCart(entry_t *e, UBYTE const *data, int len)
+{
+	int type;
+	int size;
+	if (len < 16) {
+		e->error = "truncated header";
+		return;
+	}
+	type = (data[4] << 24) | (data[5] << 16) | (data[6] << 8) | data[7];
+	if (type < 1 || type >= CARTRIDGE_TYPE_COUNT) {
+		e->cart_type = CARTRIDGE_UNKNOWN;
+		e->error = "unknown cartridge type";
+		return;
+	}
+	e->cart_type = type;
+	e->cart_candidates = 1;
+	e->machine = Is5200(type) ? "5200" : "any";
+	size = CARTRIDGES[type].kb << 10;
+	if (len - 16 < size) {
+		e->error = "truncated data";
+		return;
+	}
+	e->checksum_ok = ((data[8] << 24) | (data[9] << 16) | (data[10] << 8) | data[11])
+	                 == CARTRIDGE_Checksum(data + 16, size);
+}
+
+static void ExamineDisk(entry_t *e, UBYTE const *data, int len)
+{
+	if (e->type == AFILE_ATR || e->type == AFILE_ATR_GZ) {
+		struct AFILE_ATR_Header const *header = (struct AFILE_ATR_Header const *) data;
+		ULONG paragraphs;
+		if (len < 16) {
+			e->error = "truncated header";
+			return;
+		}
+		e->sector_size = (header->secsizehi << 8) + header->secsizelo;
+		if (e->sector_size != 128 && e->sector_size != 256) {
+			e->error = "bad sector size";
+			return;
+		}
+		/* The same arithmetic as SIO_Mount(): the header contains the
+		   length in 16-byte paragraphs, first converted to the number of
+		   128-byte sectors. */
+		paragraphs = ((ULONG) header->hiseccounthi << 24)
+			+ ((ULONG) header->hiseccountlo << 16)
+			+ (header->seccounthi << 8)
+			+ header->seccountlo;
+		e->sectors = (int) (paragraphs >> 3);
+		if (e->sector_size == 256) {
+			/* An odd number means that the first three sectors are
+			   stored with 128 bytes, an even one that they are stored
+			   full length. */
+			if ((e->sectors & 1) != 0)
+				e->sectors += 3;
+			e->sectors >>= 1;
+		}
+		if (paragraphs > (ULONG) (len - 16) / 16)
+			e->error = "truncated data";
+	}
+	else {
+		e->sector_size = 128;
+		e->sectors = len / 128;
+	}
+}
+
+/* Walks the segments of an executable, like BINLOAD_Loader() does. */
+static void ExamineXex(entry_t *e, UBYTE const *data, int len)
+{
+	int pos = 0;
+	int under_os = FALSE;
+	int basic_area = FALSE;
+	e->load_start = 0x10000;
+	e->load_end = -1;
+	while (pos < len) {
+		int start;
+		int end;
+		/* the $FFFF header may precede any segment */
+		if (len - pos >= 2 && data[pos] == 0xff && data[pos + 1] == 0xff)
+			pos += 2;
+		if (len - pos < 4) {
+			e->error = "truncated segment header";
+			break;
+		}
+		start = data[pos] + (data[pos + 1] << 8);
+		end = data[pos + 2] + (data[pos + 3] << 8);
+		pos += 4;
+		if (end < start) {
+			e->error = "bad segment";
+			break;
+		}
+		if (len - pos < end - start + 1) {
+			e->error = "truncated segment";
+			break;
+		}
+		pos += end - start + 1;
+		e->segments++;
+		/* RUNAD and INITAD say nothing about memory use */
+		if (start >= 0x2e0 && end <= 0x2e3)
+			continue;
+		if (start < e->load_start)
+			e->load_start = start;
+		if (end > e->load_end)
+			e->load_end = end;
+		if (start <= 0xbfff && end >= 0xa000)
+			basic_area = TRUE;
+		if ((start <= 0xcfff && end >= 0xc000) || end >= 0xd800)
+			under_os = TRUE;
+	}
+	if (e->load_end < 0)
+		e->load_start = e->load_end = 0;
+	if (e->error == NULL) {
+		e->machine = under_os ? "xl" : "any";
+		e->basic = basic_area ? "off" : "";
+	}
+}
+
+static void Examine(entry_t *e)
+{
+	UBYTE *data;
+	int len;
+	FILE *fp = fopen(e->path, "rb");
+	if (fp == NULL) {
+		e->error = "cannot open";
+		return;
+	}
+	if (!CRC32_FromFile(fp, &e->crc)) {
+		fclose(fp);
+		e->error = "read error";
+		return;
+	}
+	e->data_crc = e->crc;
+#ifndef HAVE_LIBZ
+	/* AFILE_DetectFileType() would only complain */
+	rewind(fp);
+	if (fgetc(fp) == 0x1f && fgetc(fp) == 0x8b) {
+		fclose(fp);
+		e->error = "compressed files not supported";
+		return;
+	}
+#endif
+	fclose(fp);
+
+	e->type = AFILE_DetectFileType(e->path);
+	if (e->type == AFILE_ERROR)
+		return;
+	if (e->type == AFILE_STATE || e->type == AFILE_STATE_GZ || e->type == AFILE_ATX
+	    || e->type == AFILE_PRO || e->type == AFILE_CAS)
+		return;
+	if (e->type == AFILE_DCM) {
+		e->sector_size = 128;
+		return;
+	}
+	if (e->type == AFILE_BAS || e->type == AFILE_LST) {
+		e->machine = "any";
+		e->basic = "on";
+		return;
+	}
+
+	/* uncompresses gzipped files */
+	data = CompFile_ReadFile(e->path, &len);
+	if (data == NULL) {
+		e->error = "cannot uncompress";
+		return;
+	}
+	e->data_crc = ~CRC32_Update(0xffffffff, data, len);
+	switch (e->type) {
+	case AFILE_ROM:
+		ExamineRom(e, len);
+		break;
+	case AFILE_CART:
+		ExamineCart(e, data, len);
+		break;
+	case AFILE_ATR:
+	case AFILE_ATR_GZ:
+	case AFILE_XFD:
+	case AFILE_XFD_GZ:
+		ExamineDisk(e, data, len);
+		break;
+	case AFILE_XEX:
+		ExamineXex(e, data, len);
+		break;
+	case AFILE_BOOT_TAPE:
+		e->machine = "any";
+		break;
+	default:
+		break;
+	}
+	free(data);
+}
+
+static void *Worker(void *arg)
+{
+	for (;;) {
+		int i;
+		pthread_mutex_lock(&next_mutex);
+		i = next_entry++;
+		pthread_mutex_unlock(&next_mutex);
+		if (i >= num_entries)
+			break;
+		Examine(&entries[i]);
+	}
+	return NULL;
+}
+
+static void PutJSONString(FILE *out, const char *s)
+{
+	fputc('"', out);
+	for (; *s != '\0'; s++) {
+		unsigned char c = (unsigned char) *s;
+		if (c == '"' || c == '\\')
+			fprintf(out, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(out, "\\u%04x", c);
+		else
+			fputc(c, out);
+	}
+	fputc('"', out);
+}
+
+static void PutCSVString(FILE *out, const char *s)
+{
+	if (strpbrk(s, ",\"\n\r") == NULL) {
+		fputs(s, out);
+		return;
+	}
+	fputc('"', out);
+	for (; *s != '\0'; s++) {
+		if (*s == '"')
+			fputc('"', out);
+		fputc(*s, out);
+	}
+	fputc('"', out);
+}
+
+static void WriteJSON(FILE *out)
+{
+	int i;
+	fputs("[\n", out);
+	for (i = 0; i < num_entries; i++) {
+		entry_t const *e = &entries[i];
+		fputs("  {\"path\": ", out);
+		PutJSONString(out, e->path);
+		fprintf(out, ", \"size\": %ld, \"type\": \"%s\", \"crc32\": \"%08x\", \"data_crc32\": \"%08x\"",
+		        e->size, TypeName(e->type), e->crc, e->data_crc);
+		if (e->type == AFILE_CART || e->type == AFILE_ROM) {
+			fprintf(out, ", \"cart_type\": %d, \"cart_candidates\": %d", e->cart_type, e->cart_candidates);
+			if (e->cart_type > 0)
+				fprintf(out, ", \"cart_name\": \"%s\"", CARTRIDGES[e->cart_type].description);
+			if (e->type == AFILE_CART)
+				fprintf(out, ", \"checksum_ok\": %s", e->checksum_ok ? "true" : "false");
+		}
+		if (e->sector_size != 0)
+			fprintf(out, ", \"sectors\": %d, \"sector_size\": %d", e->sectors, e->sector_size);
+		if (e->type == AFILE_XEX)
+			fprintf(out, ", \"segments\": %d, \"load_start\": %d, \"load_end\": %d",
+			        e->segments, e->load_start, e->load_end);
+		fprintf(out, ", \"machine\": \"%s\", \"basic\": \"%s\"", e->machine, e->basic);
+		if (e->error != NULL)
+			fprintf(out, ", \"error\": \"%s\"", e->error);
+		fputs(i + 1 < num_entries ? "},\n" : "}\n", out);
+	}
+	fputs("]\n", out);
+}
+
+static void WriteCSV(FILE *out)
+{
+	int i;
+	fputs("path,size,type,crc32,data_crc32,cart_type,cart_candidates,cart_name,checksum_ok,"
+	      "sectors,sector_size,segments,load_start,load_end,machine,basic,error\n", out);
+	for (i = 0; i < num_entries; i++) {
+		entry_t const *e = &entries[i];
+		int cart = e->type == AFILE_CART || e->type == AFILE_ROM;
+		PutCSVString(out, e->path);
+		fprintf(out, ",%ld,%s,%08x,%08x,", e->size, TypeName(e->type), e->crc, e->data_crc);
+		if (cart)
+			fprintf(out, "%d,%d,", e->cart_type, e->cart_candidates);
+		else
+			fputs(",,", out);
+		if (e->cart_type > 0)
+			PutCSVString(out, CARTRIDGES[e->cart_type].description);
+		fprintf(out, ",%s,", e->type == AFILE_CART ? (e->checksum_ok ? "1" : "0") : "");
+		if (e->sector_size != 0)
+			fprintf(out, "%d,%d,", e->sectors, e->sector_size);
+		else
+			fputs(",,", out);
+		if (e->type == AFILE_XEX)
+			fprintf(out, "%d,%d,%d,", e->segments, e->load_start, e->load_end);
+		else
+			fputs(",,,", out);
+		fprintf(out, "%s,%s,%s\n", e->machine, e->basic, e->error != NULL ? e->error : "");
+	}
+}
+
+static void Usage(void)
+{
+	printf("Usage: imgscan [options] file-or-directory...\n"
+	       "\t-json      Write a JSON array (default)\n"
+	       "\t-csv       Write CSV\n"
+	       "\t-o <file>  Write the manifest to file instead of standard output\n"
+	       "\t-j <n>     Number of threads (default: number of processors)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	pthread_t threads[MAX_THREADS];
+	const char *out_name = NULL;
+	int csv = FALSE;
+	int num_threads = 0;
+	int started;
+	int paths = 0;
+	FILE *out = stdout;
+	double start;
+	int i;
+
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-json") == 0)
+			csv = FALSE;
+		else if (strcmp(argv[i], "-csv") == 0)
+			csv = TRUE;
+		else if (strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+			out_name = argv[++i];
+		else if (strcmp(argv[i], "-j") == 0 && i + 1 < argc)
+			num_threads = atoi(argv[++i]);
+		else if (argv[i][0] == '-') {
+			Usage();
+			return 1;
+		}
+		else {
+			Walk(argv[i]);
+			paths++;
+		}
+	}
+	if (paths == 0) {
+		Usage();
+		return 1;
+	}
+	if (num_threads <= 0) {
+#ifdef _SC_NPROCESSORS_ONLN
+		num_threads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+		if (num_threads <= 0)
+			num_threads = 1;
+	}
+	if (num_threads > MAX_THREADS)
+		num_threads = MAX_THREADS;
+
+	/* sorted, so the manifest doesn't depend on the directory order */
+	qsort(entries, num_entries, sizeof(entry_t), ComparePaths);
+
+	start = Util_time();
+	for (started = 0; started < num_threads; started++)
+		if (pthread_create(&threads[started], NULL, &Worker, NULL) != 0)
+			break;
+	/* no threads: examine the files in this one */
+	if (started == 0)
+		Worker(NULL);
+	for (i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+
+	if (out_name != NULL && (out = fopen(out_name, "w")) == NULL) {
+		perror(out_name);
+		return 2;
+	}
+	if (csv)
+		WriteCSV(out);
+	else
+		WriteJSON(out);
+	if (out != stdout)
+		fclose(out);
+	fprintf(stderr, "%d files examined by %d threads in %.2f s\n",
+	        num_entries, started == 0 ? 1 : started, Util_time() - start);
+	return 0;
+}
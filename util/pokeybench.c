@@ -3,7 +3,7 @@
  *  Atari800  Atari 800XL, etc. emulator                                     *
  *  ----------------------------------------------------------------------   *
  *  POKEY Chip Emulator,                                                     *
- *  "POKEYBENCH" Test and benchmark program for developers, V1.3             *
+ *  "POKEYBENCH" Test and benchmark program for developers, V1.4             *
  *  by Michael Borisov                                                       *
  *                                                                           *
  *****************************************************************************/
@@ -32,9 +32,15 @@
  *                                                                           *
  *****************************************************************************/
 
+#include "pokey.h"
 #include "pokeysnd.h"
 #include "mzpokeysnd.h"
 
+/* Build by linking with the emulator's objects, eg.:
+   cc -I../src pokeybench.c ../src/libatari800.a -lm
+   or run "make bench-pokey" in a libatari800 build, which runs the
+   regression suite (pokeybench -suite pokeybench.golden). */
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -54,6 +60,20 @@
 /* How many seconds of sound to save in the outfile */
 #define MZM_SAVE_TIME 10
 
+/* Largest allowed difference between the floating point and the fixed
+   point engine, in LSBs. Both add their own dither of +-0.25 LSB. */
+#define MZM_TOLERANCE 2
+
+
+/* Seconds of sound per configuration in the regression suite */
+#define SUITE_TIME 10
+
+/* How many times per second the suite changes the registers */
+#define SUITE_STEPS 50
+
+/* Longest configuration name in the golden file */
+#define SUITE_NAME_LEN 64
+
 
 /* Wrapper for fgets, removes trailing whitespace */
 char* fgetl(char* s, int len, FILE* fs)
@@ -70,21 +90,44 @@ char* fgetl(char* s, int len, FILE* fs)
     return s2;
 }
 
-int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
-           const char* ofn8, const char* ofn16,
-           unsigned short samplerate)
+/* Initializes the sound engine and sets the Pokey registers */
+int pkinit(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+           unsigned short samplerate, int flags)
+{
+    int i;
+
+    POKEYSND_enable_new_pokey = 1;
+    POKEYSND_SetMzQuality(1);
+    if((i=POKEYSND_Init(POKEYSND_FREQ_17_EXACT,samplerate,1,flags)))
+    {
+        printf("Error initializing Pokey sound: %d\n",i);
+        return 1;
+    }
+
+    POKEYSND_Update(POKEY_OFFSET_AUDF1,audf[0],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDC1,audc[0],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDF2,audf[1],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDC2,audc[1],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDF3,audf[2],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDC3,audc[2],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDF4,audf[3],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDC4,audc[3],0,1);
+    POKEYSND_Update(POKEY_OFFSET_AUDCTL,audctl,0,1);
+    return 0;
+}
+
+/* Measures the generation speed */
+int pkbench(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+            unsigned short samplerate)
 {
     unsigned char* buf;
-    short* buf16;
     double rate;
     double rasum;
     double rasum2;
     double varian;
     double stddev;
-    unsigned long samremain, samproc;
     int i;
     time_t start,finish;
-    FILE* ft;
 
     buf = malloc(MZM_BUF_SAMPLES);
     if(buf == NULL)
@@ -93,24 +136,12 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         return 1;
     }
 
-    if(i=Pokey_sound_init(1790000,samplerate,1,0,1))
+    if(pkinit(audf,audc,audctl,samplerate,0))
     {
-        printf("Error initializing Pokey sound: %d\n",i);
+        free(buf);
         return 1;
     }
 
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
-    
-
     rasum = 0.0;
     rasum2 = 0.0;
 
@@ -129,7 +160,7 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         /* Generate until test time elapses */
         do
         {
-            Pokey_process(buf,MZM_BUF_SAMPLES);
+            POKEYSND_Process(buf,MZM_BUF_SAMPLES);
             rate += MZM_BUF_SAMPLES;
             time(&finish);
         } while(difftime(finish,start) < MZM_TRIAL_TIME);
@@ -152,33 +183,41 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
 
     printf("Gen/play ratio = %3.1f\n",rasum/TEST_TRIALS/samplerate);
 
-    /* And now, write 8-bit output file */
+    free(buf);
+    return 0;
+}
+
+/* Writes MZM_SAVE_TIME seconds of sound to the file OFN */
+int pksave(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+           const char* ofn, unsigned short samplerate, int flags)
+{
+    int samsize = (flags & POKEYSND_BIT16) ? 2 : 1;
+    unsigned char* buf;
+    unsigned long samremain, samproc;
+    unsigned long i;
+    FILE* ft;
+
+    buf = malloc(samsize*MZM_BUF_SAMPLES);
+    if(buf == NULL)
+    {
+        printf("Out of memory\n");
+        return 1;
+    }
 
-    if(i=Pokey_sound_init(1790000,samplerate,1,0,1))
+    if(pkinit(audf,audc,audctl,samplerate,flags))
     {
-        printf("Error initializing Pokey sound: %d\n",i);
         free(buf);
         return 1;
     }
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
-
-    if(!(ft=fopen(ofn8,"wb")))
+
+    if(!(ft=fopen(ofn,"wb")))
     {
-        perror(ofn8);
+        perror(ofn);
         free(buf);
         return 2;
     }
 
-    samremain = samplerate*MZM_SAVE_TIME;
+    samremain = (unsigned long)samplerate*MZM_SAVE_TIME;
     while(samremain>0)
     {
         if(samremain>=MZM_BUF_SAMPLES)
@@ -189,11 +228,11 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
         {
             samproc = samremain;
         }
-        Pokey_process(buf,(unsigned short)samproc);
-        i = fwrite(buf,1,samproc,ft);
+        POKEYSND_Process(buf,(int)samproc);
+        i = fwrite(buf,samsize,samproc,ft);
         if(i<samproc)
         {
-            perror(ofn8);
+            perror(ofn);
             free(buf);
             fclose(ft);
             return 2;
@@ -203,66 +242,296 @@ int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
 
     free(buf);
     fclose(ft);
+    return 0;
+}
 
-    /* Write 16-bit output file */
-
-    if(i=Pokey_sound_init(1790000,samplerate,1,SND_BIT16,1))
+/* Generates MZM_SAVE_TIME seconds of sound with the floating point and
+   with the fixed point engine and compares the results */
+int pkcompare(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+              unsigned short samplerate, int flags)
+{
+    int samsize = (flags & POKEYSND_BIT16) ? 2 : 1;
+    unsigned long nsam = (unsigned long)samplerate*MZM_SAVE_TIME;
+    unsigned char* buf[2];
+    unsigned long i;
+    int mode;
+    int maxdiff = 0;
+    double sum2 = 0.0;
+
+    buf[0] = malloc(samsize*nsam);
+    buf[1] = malloc(samsize*nsam);
+    if(buf[0] == NULL || buf[1] == NULL)
     {
-        printf("Error initializing Pokey sound: %d\n",i);
+        printf("Out of memory\n");
+        free(buf[0]);
+        free(buf[1]);
         return 1;
     }
-    Update_pokey_sound(_AUDF1,audf[0],0,1);
-    Update_pokey_sound(_AUDC1,audc[0],0,1);
-    Update_pokey_sound(_AUDF2,audf[1],0,1);
-    Update_pokey_sound(_AUDC2,audc[1],0,1);
-    Update_pokey_sound(_AUDF3,audf[2],0,1);
-    Update_pokey_sound(_AUDC3,audc[2],0,1);
-    Update_pokey_sound(_AUDF4,audf[3],0,1);
-    Update_pokey_sound(_AUDC4,audc[3],0,1);
-    Update_pokey_sound(_AUDCTL,audctl,0,1);
-    Pokey_debugreset(0);
-
-
-    buf16 = malloc(2*MZM_BUF_SAMPLES);
-    if(buf16 == NULL)
+
+    for(mode=0; mode<2; mode++)
+    {
+        MZPOKEYSND_fixed_point = mode;
+        if(pkinit(audf,audc,audctl,samplerate,flags))
+        {
+            MZPOKEYSND_fixed_point = 0;
+            free(buf[0]);
+            free(buf[1]);
+            return 1;
+        }
+        for(i=0; i<nsam; i+=MZM_BUF_SAMPLES)
+            POKEYSND_Process(buf[mode] + i*samsize,
+                nsam-i<MZM_BUF_SAMPLES ? (int)(nsam-i) : MZM_BUF_SAMPLES);
+    }
+    MZPOKEYSND_fixed_point = 0;
+
+    for(i=0; i<nsam; i++)
+    {
+        int diff;
+        if(samsize == 2)
+            diff = ((short*)buf[1])[i] - ((short*)buf[0])[i];
+        else
+            diff = buf[1][i] - buf[0][i];
+        sum2 += (double)diff*diff;
+        if(abs(diff) > maxdiff)
+            maxdiff = abs(diff);
+    }
+    free(buf[0]);
+    free(buf[1]);
+
+    printf("Fixed point vs floating point (%d-bit): max difference %d, RMS %.3f\n",
+        samsize*8, maxdiff, sqrt(sum2/nsam));
+    if(maxdiff > MZM_TOLERANCE)
+    {
+        printf("Difference exceeds tolerance of %d\n", MZM_TOLERANCE);
+        return 3;
+    }
+    return 0;
+}
+
+int pktest(unsigned char *audf, unsigned char *audc, unsigned char audctl,
+           const char* ofn8, const char* ofn16,
+           unsigned short samplerate)
+{
+    int i;
+
+    printf("Floating point:\n");
+    if((i=pkbench(audf,audc,audctl,samplerate)))
+        return i;
+    printf("\nFixed point:\n");
+    MZPOKEYSND_fixed_point = 1;
+    i = pkbench(audf,audc,audctl,samplerate);
+    MZPOKEYSND_fixed_point = 0;
+    if(i)
+        return i;
+    printf("\n");
+
+    /* Write output files */
+    if((i=pksave(audf,audc,audctl,ofn8,samplerate,0)))
+        return i;
+    if((i=pksave(audf,audc,audctl,ofn16,samplerate,POKEYSND_BIT16)))
+        return i;
+
+    /* Check that the fixed point engine matches the floating point one */
+    if((i=pkcompare(audf,audc,audctl,samplerate,0)))
+        return i;
+    return pkcompare(audf,audc,audctl,samplerate,POKEYSND_BIT16);
+}
+
+/* Regression suite. Every engine plays the same random register sequence
+   at every quality level, sample rate, sample size and number of POKEYs.
+   The speed of each configuration is printed and a hash of its output is
+   compared with a golden file, so changes to the engines that alter the
+   sound are noticed. Results depend on the build options (eg.
+   NONLINEAR_MIXING) and on the floating point behaviour of the compiler;
+   run with -update to record new hashes. */
+
+typedef struct
+{
+    const char *name;
+    int new_pokey;
+    int quality;
+    int fixed_point;
+} suite_engine;
+
+static const suite_engine suite_engines[] =
+{
+    {"rf", 0, 0, 0},
+    {"mz-q0", 1, 0, 0},
+    {"mz-q1", 1, 1, 0},
+    {"mz-q2", 1, 2, 0},
+    {"mz-q0-fix", 1, 0, 1},
+    {"mz-q1-fix", 1, 1, 1},
+    {"mz-q2-fix", 1, 2, 1}
+};
+
+static const unsigned short suite_rates[] = {22050, 44100, 48000};
+
+static unsigned long suite_seed;
+
+/* Portable LCG, so the register sequence is the same everywhere */
+unsigned char suite_rand(void)
+{
+    suite_seed = (suite_seed * 1103515245UL + 12345UL) & 0xffffffffUL;
+    return (unsigned char)(suite_seed >> 16);
+}
+
+/* Writes random values to the sound registers of POKEY CHIP. Volume-only
+   mode is avoided, as it depends on the emulated CPU clock. */
+void suite_regs(int chip)
+{
+    int i;
+
+    for(i=0; i<4; i++)
+    {
+        POKEYSND_Update(POKEY_OFFSET_AUDF1+2*i,suite_rand(),chip,1);
+        POKEYSND_Update(POKEY_OFFSET_AUDC1+2*i,suite_rand()&0xef,chip,1);
+    }
+    POKEYSND_Update(POKEY_OFFSET_AUDCTL,suite_rand(),chip,1);
+}
+
+/* Plays SUITE_TIME seconds of the suite sequence. Returns the FNV-1a hash
+   of the output in *HASH and the speed in samples per second in *SPEED. */
+int suite_run(const suite_engine *engine, unsigned short samplerate,
+              int flags, int pokeys, unsigned long *hash, double *speed)
+{
+    int samsize = (flags & POKEYSND_BIT16) ? 2 : 1;
+    int step = samplerate / SUITE_STEPS;
+    unsigned char *buf;
+    unsigned long h = 2166136261UL;
+    clock_t start;
+    double secs;
+    int i, j, chip;
+
+    buf = malloc(samsize*pokeys*step);
+    if(buf == NULL)
     {
         printf("Out of memory\n");
         return 1;
     }
 
-    if(!(ft=fopen(ofn16,"wb")))
+    POKEYSND_enable_new_pokey = engine->new_pokey;
+    POKEYSND_SetMzQuality(engine->quality);
+    MZPOKEYSND_fixed_point = engine->fixed_point;
+#ifdef STEREO_SOUND
+    POKEYSND_stereo_enabled = pokeys > 1;
+#endif
+    if((i=POKEYSND_Init(POKEYSND_FREQ_17_EXACT,samplerate,(unsigned char)pokeys,flags)))
     {
-        perror(ofn16);
-        free(buf16);
-        return 2;
+        printf("Error initializing Pokey sound: %d\n",i);
+        free(buf);
+        return 1;
     }
 
-    samremain = samplerate*MZM_SAVE_TIME;
-    while(samremain>0)
+    suite_seed = 1;
+    start = clock();
+    for(i=0; i<SUITE_TIME*SUITE_STEPS; i++)
     {
-        if(samremain>=MZM_BUF_SAMPLES)
-        {
-            samproc = MZM_BUF_SAMPLES;
-        }
-        else
-        {
-            samproc = samremain;
-        }
-        Pokey_process(buf16,(unsigned short)samproc);
-        i = fwrite(buf16,2,samproc,ft);
-        if(i<samproc)
+        for(chip=0; chip<pokeys; chip++)
+            suite_regs(chip);
+        POKEYSND_Process(buf,step*pokeys);
+        for(j=0; j<samsize*pokeys*step; j++)
+            h = ((h ^ buf[j]) * 16777619UL) & 0xffffffffUL;
+    }
+    secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    MZPOKEYSND_fixed_point = 0;
+#ifdef STEREO_SOUND
+    POKEYSND_stereo_enabled = 0;
+#endif
+    free(buf);
+    *hash = h;
+    *speed = secs > 0.0 ? (double)step*SUITE_TIME*SUITE_STEPS/secs : 0.0;
+    return 0;
+}
+
+/* Looks up NAME in the golden file FS. Returns 0 if not found. */
+int suite_golden(FILE *fs, const char *name, unsigned long *hash)
+{
+    char line[SUITE_NAME_LEN+16];
+    char gname[SUITE_NAME_LEN];
+
+    rewind(fs);
+    while(fgets(line,sizeof(line),fs) != NULL)
+    {
+        if(sscanf(line,"%63s %lx",gname,hash) == 2 && strcmp(gname,name) == 0)
+            return 1;
+    }
+    return 0;
+}
+
+int pksuite(const char *golden_fn, int update)
+{
+    FILE *fs = NULL;
+    char name[SUITE_NAME_LEN];
+    unsigned long hash, golden;
+    double speed;
+    int e, r, bits, pokeys;
+    int failed = 0;
+    int maxpokeys = 1;
+
+#ifdef STEREO_SOUND
+    maxpokeys = 2;
+#endif
+
+    if(golden_fn != NULL)
+    {
+        if(!(fs = fopen(golden_fn,update ? "w" : "r")))
         {
-            perror(ofn16);
-            free(buf16);
-            fclose(ft);
+            perror(golden_fn);
             return 2;
         }
-        samremain -= samproc;
     }
 
-    free(buf16);
-    fclose(ft);
-
+    printf("%-28s %12s %8s %9s\n","Configuration","samples/sec","x real","hash");
+    for(e=0; e<(int)(sizeof(suite_engines)/sizeof(suite_engines[0])); e++)
+        for(r=0; r<(int)(sizeof(suite_rates)/sizeof(suite_rates[0])); r++)
+            for(bits=8; bits<=16; bits+=8)
+                for(pokeys=1; pokeys<=maxpokeys; pokeys++)
+                {
+                    const char *result = "";
+                    sprintf(name,"%s/%u/%d/%s",suite_engines[e].name,
+                        suite_rates[r],bits,pokeys > 1 ? "stereo" : "mono");
+                    if(suite_run(&suite_engines[e],suite_rates[r],
+                                 bits == 16 ? POKEYSND_BIT16 : 0,pokeys,
+                                 &hash,&speed))
+                    {
+                        if(fs != NULL)
+                            fclose(fs);
+                        return 1;
+                    }
+                    if(fs != NULL && update)
+                        fprintf(fs,"%s %08lx\n",name,hash);
+                    else if(fs != NULL)
+                    {
+                        if(!suite_golden(fs,name,&golden))
+                        {
+                            result = "  missing";
+                            failed++;
+                        }
+                        else if(golden != hash)
+                        {
+                            result = "  FAILED";
+                            failed++;
+                        }
+                    }
+                    printf("%-28s %12.0f %8.1f  %08lx%s\n",name,speed,
+                        speed/suite_rates[r],hash,result);
+                    fflush(stdout);
+                }
+
+    if(fs != NULL)
+        fclose(fs);
+    if(update)
+        printf("\nWrote %s\n",golden_fn);
+    else if(fs != NULL)
+    {
+        if(failed)
+        {
+            printf("\n%d configurations differ from %s\n",failed,golden_fn);
+            return 3;
+        }
+        printf("\nAll configurations match %s\n",golden_fn);
+    }
     return 0;
 }
 
@@ -281,6 +550,11 @@ int main(int argc, char* argv[])
 
     printf("PokeyBench (c) 2002 by Michael Borisov\n\n");
 
+    /* pokeybench -suite [golden file [-update]] */
+    if(argc>=2 && strcmp(argv[1],"-suite") == 0)
+        return pksuite(argc>=3 ? argv[2] : NULL,
+                       argc>=4 && strcmp(argv[3],"-update") == 0);
+
     /* Get command-line parameters */
     if(argc<2)
     {
@@ -0,0 +1,252 @@
+/*
+ * pokeyplay.c - renders a binary POKEY register log to a WAV file
+ *
+ * Copyright (C) 2026 Atari800 development team (see DOC/CREDITS)
+ *
+ * This file is part of the Atari800 emulator project which emulates
+ * the Atari 400, 800, 800XL, 130XE, and 5200 8-bit computers.
+ *
+ * Atari800 is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * Atari800 is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Atari800; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+*/
+
+/* Plays a log written by atari800 -pokeyrec-binary or -pokeyrec-compress
+   through either sound engine, as fast as the engine runs. Every register
+   write is applied at the sample it falls on.
+
+   Build by linking with the emulator's objects, eg.:
+   cc -I../src pokeyplay.c ../src/libatari800.a -lz -lm */
+
+#include "config.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+
+#include "atari.h"
+#include "antic.h"
+#include "pokey.h"
+#include "pokeyrec.h"
+#include "pokeysnd.h"
+
+/* Value of SOUND_GAIN in pokey.c */
+#define GAIN 4
+
+/* Twice the CPU clock, in Hz */
+#define CLOCK2_PAL 3546895
+#define CLOCK2_NTSC 3579545
+
+#define BUF_SAMPLES 4096
+
+static gzFile in;
+static FILE *out;
+static UBYTE *buf;
+static int sample_bytes;
+static unsigned long out_bytes = 0;
+
+static void put16(unsigned int x)
+{
+	fputc(x & 0xff, out);
+	fputc((x >> 8) & 0xff, out);
+}
+
+static void put32(unsigned long x)
+{
+	put16(x & 0xffff);
+	put16((x >> 16) & 0xffff);
+}
+
+static void WriteWavHeader(int freq, int channels, int bits)
+{
+	fputs("RIFF", out);
+	put32(out_bytes + 36);
+	fputs("WAVEfmt ", out);
+	put32(16);
+	put16(1);
+	put16(channels);
+	put32(freq);
+	put32((unsigned long) freq * channels * bits / 8);
+	put16(channels * bits / 8);
+	put16(bits);
+	fputs("data", out);
+	put32(out_bytes);
+}
+
+/* Generates N samples (per channel). */
+static void Generate(unsigned long long n, int write)
+{
+	while (n > 0) {
+		int len = n > BUF_SAMPLES ? BUF_SAMPLES : (int) n;
+		POKEYSND_Process(buf, len * POKEYSND_num_pokeys);
+		if (write) {
+			fwrite(buf, 1, len * sample_bytes, out);
+			out_bytes += len * sample_bytes;
+		}
+		n -= len;
+	}
+}
+
+/* Reads an unsigned LEB128 number. Returns -1 at the end of the file. */
+static long ReadDelta(void)
+{
+	unsigned long delta = 0;
+	int shift = 0;
+	int c;
+	do {
+		if ((c = gzgetc(in)) < 0)
+			return -1;
+		delta |= (unsigned long) (c & 0x7f) << shift;
+		shift += 7;
+	} while (c & 0x80);
+	return (long) delta;
+}
+
+static void Usage(void)
+{
+	printf("Usage: pokeyplay [options] input output.wav\n"
+	       "\t-old         Use the old sound engine\n"
+	       "\t-new         Use the new (MZ) sound engine (default)\n"
+	       "\t-rate <n>    Sample rate (default 44100)\n"
+	       "\t-quality <n> Quality of the new engine, 0-2\n"
+	       "\t-8bit        Write 8-bit samples (default 16-bit)\n");
+}
+
+int main(int argc, char *argv[])
+{
+	UBYTE header[POKEYREC_HEADER_SIZE];
+	const char *in_name = NULL;
+	const char *out_name = NULL;
+	int freq = 44100;
+	int quality = -1;
+	int bit16 = TRUE;
+	int stereo;
+	int lines;
+	unsigned long clock2;
+	unsigned long long cycle;
+	unsigned long long first_sample;
+	unsigned long long samples = 0;
+	unsigned long writes = 0;
+	clock_t start;
+	double secs;
+	int i;
+
+	POKEYSND_enable_new_pokey = TRUE;
+	for (i = 1; i < argc; i++) {
+		if (strcmp(argv[i], "-old") == 0)
+			POKEYSND_enable_new_pokey = FALSE;
+		else if (strcmp(argv[i], "-new") == 0)
+			POKEYSND_enable_new_pokey = TRUE;
+		else if (strcmp(argv[i], "-rate") == 0 && i + 1 < argc)
+			freq = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-quality") == 0 && i + 1 < argc)
+			quality = atoi(argv[++i]);
+		else if (strcmp(argv[i], "-8bit") == 0)
+			bit16 = FALSE;
+		else if (in_name == NULL)
+			in_name = argv[i];
+		else if (out_name == NULL)
+			out_name = argv[i];
+		else {
+			Usage();
+			return 1;
+		}
+	}
+	if (out_name == NULL || freq < 8192 || freq > 65535) {
+		Usage();
+		return 1;
+	}
+
+	/* gzread reads uncompressed files, too */
+	if ((in = gzopen(in_name, "rb")) == NULL) {
+		perror(in_name);
+		return 2;
+	}
+	if (gzread(in, header, POKEYREC_HEADER_SIZE) != POKEYREC_HEADER_SIZE
+	 || memcmp(header, POKEYREC_MAGIC, 8) != 0) {
+		printf("%s: not a POKEY register log\n", in_name);
+		return 2;
+	}
+	if (header[8] > POKEYREC_VERSION) {
+		printf("%s: unsupported version %d\n", in_name, header[8]);
+		return 2;
+	}
+	stereo = (header[9] & POKEYREC_STEREO) != 0;
+	lines = header[10] | (header[11] << 8);
+	Atari800_tv_mode = lines == Atari800_TV_NTSC ? Atari800_TV_NTSC : Atari800_TV_PAL;
+	clock2 = Atari800_tv_mode == Atari800_TV_PAL ? CLOCK2_PAL : CLOCK2_NTSC;
+	/* Count cycles from the start of the emulation, so sample boundaries
+	   fall where they did in the emulator. */
+	cycle = header[12] | (header[13] << 8) | (header[14] << 16) | ((unsigned long) header[15] << 24);
+	first_sample = cycle * 2 * freq / clock2;
+
+#ifdef STEREO_SOUND
+	POKEYSND_stereo_enabled = stereo;
+#else
+	if (stereo)
+		printf("Stereo not compiled in, playing the first POKEY only\n");
+#endif
+	if (quality >= 0)
+		POKEYSND_SetMzQuality(quality);
+	ANTIC_screenline_cpu_clock = 0;
+	POKEYSND_Init(POKEYSND_FREQ_17_EXACT, freq, (UBYTE) (POKEYSND_stereo_enabled ? 2 : 1),
+	              bit16 ? POKEYSND_BIT16 : 0);
+	sample_bytes = POKEYSND_num_pokeys * (bit16 ? 2 : 1);
+	buf = (UBYTE *) malloc(BUF_SAMPLES * sample_bytes);
+	if (buf == NULL) {
+		printf("Out of memory\n");
+		return 3;
+	}
+	if ((out = fopen(out_name, "wb")) == NULL) {
+		perror(out_name);
+		return 2;
+	}
+	WriteWavHeader(freq, POKEYSND_num_pokeys, bit16 ? 16 : 8);
+
+	start = clock();
+	/* Run the engine from the start of the emulation, so its counters
+	   are in the same phase as in the emulator. */
+	Generate(first_sample, FALSE);
+	for (;;) {
+		unsigned long long target;
+		long delta = ReadDelta();
+		int reg;
+		int val;
+		if (delta < 0 || (reg = gzgetc(in)) < 0)
+			break;
+		cycle += delta;
+		/* samples produced until this write */
+		target = cycle * 2 * freq / clock2 - first_sample;
+		ANTIC_screenline_cpu_clock = (unsigned int) cycle - ANTIC_XPOS;
+		Generate(target - samples, TRUE);
+		samples = target;
+		if (reg == POKEYREC_END || (val = gzgetc(in)) < 0)
+			break;
+		if ((reg & 0x10) == 0 || POKEYSND_num_pokeys > 1)
+			POKEYSND_Update((UWORD) (reg & 0x0f), (UBYTE) val, (UBYTE) (reg >> 4), GAIN);
+		writes++;
+	}
+	secs = (double) (clock() - start) / CLOCKS_PER_SEC;
+	gzclose(in);
+
+	fseek(out, 0, SEEK_SET);
+	WriteWavHeader(freq, POKEYSND_num_pokeys, bit16 ? 16 : 8);
+	fclose(out);
+	free(buf);
+
+	printf("%lu writes, %.2f s of sound rendered in %.2f s (%.0fx real time)\n",
+	       writes, (double) samples / freq, secs,
+	       secs > 0 ? (double) samples / freq / secs : 0.0);
+	return 0;
+}